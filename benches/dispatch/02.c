@@ -0,0 +1,43 @@
+// tagged union, one switch per phase
+
+#include "dispatch.h"
+#include "traditional_dispatch.h"
+
+
+static void *parse(const char *corpus, size_t len, char **lines, int count)
+{
+	(void) corpus;
+	(void) len;
+
+	struct payload_buffer *buf = new_buffer();
+
+	for (int i = 0; i < count; i++)
+		push_payload(buf, lines[i]);
+
+	return buf;
+}
+
+static void process(void *buf)
+{
+	struct payload_buffer *b = buf;
+
+	while (b->process_base < b->len)
+		process_next(b);
+}
+
+static void teardown(void *buf)
+{
+	destroy(buf);
+}
+
+int main(void)
+{
+	static const struct dispatch_strategy strategy = {
+		.name = "02 switch",
+		.parse = parse,
+		.process = process,
+		.destroy = teardown,
+	};
+
+	return dispatch_main(&strategy);
+}
@@ -0,0 +1,46 @@
+// vtables shared by every payload of a type
+
+#include "dispatch.h"
+#include "dynamic_dispatch.h"
+#include "parallel_ingest.h"
+#include "payload_file.h"
+
+
+static void *parse(const char *corpus, size_t len, char **lines, int count)
+{
+	(void) lines;
+	(void) count;
+
+	// the block parser indexes the whole corpus and parses from the index
+	struct payload_file file = { .data = corpus, .len = len };
+	struct payload_buffer *buf = new_buffer();
+
+	push_payloads_parallel(buf, &file, 1);
+
+	return buf;
+}
+
+static void process(void *buf)
+{
+	struct payload_buffer *b = buf;
+
+	while (b->process_base < b->len)
+		process_next(b);
+}
+
+static void teardown(void *buf)
+{
+	destroy(buf);
+}
+
+int main(void)
+{
+	static const struct dispatch_strategy strategy = {
+		.name = "04 vtable",
+		.parse = parse,
+		.process = process,
+		.destroy = teardown,
+	};
+
+	return dispatch_main(&strategy);
+}
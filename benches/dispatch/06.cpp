@@ -0,0 +1,86 @@
+// C++ virtual methods
+
+#include "dispatch.h"
+#include "payload.hpp"
+
+#include <cstring>
+#include <vector>
+
+
+// solutions/06 constructs payloads but has no parser, this one mirrors the
+// C parsers: a command name or receiver, then space-separated arguments
+
+/* copies the token at line into token, returns the rest after the space */
+static const char *next_token(const char *line, char *token) {
+    std::size_t len = std::strcspn(line, " ");
+
+    std::memcpy(token, line, len);
+    token[len] = '\0';
+
+    return line[len] == ' ' ? line + len + 1 : line + len;
+}
+
+static Payload *parse_line(const char *line) {
+    char name[128], argument[128];
+
+    switch (line[0]) {
+    case '/': {
+        const char *rest = next_token(line + 1, name);
+
+        if (std::strcmp(name, "login") == 0) {
+            rest = next_token(rest, argument);
+            next_token(rest, name);
+
+            return new LoginCommand { argument, name };
+        }
+
+        if (std::strcmp(name, "join") == 0) {
+            next_token(rest, argument);
+
+            return new JoinCommand { argument };
+        }
+
+        return new LogoutCommand {};
+    }
+    case '@':
+        line = next_token(line + 1, name);
+        return new DirectMessage { line, name };
+    case '#':
+        line = next_token(line + 1, name);
+        return new GroupMessage { line, name };
+    default:
+        return new GlobalMessage { line };
+    }
+}
+
+static void *parse(const char *, std::size_t, char **lines, int count) {
+    auto payloads = new std::vector<Payload *>;
+    payloads->reserve(count);
+
+    for (int i = 0; i < count; i++)
+        payloads->push_back(parse_line(lines[i]));
+
+    return payloads;
+}
+
+static void process(void *buf) {
+    for (Payload *payload : *static_cast<std::vector<Payload *> *>(buf))
+        payload->process();
+}
+
+static void teardown(void *buf) {
+    auto payloads = static_cast<std::vector<Payload *> *>(buf);
+
+    for (Payload *payload : *payloads)
+        delete payload;
+
+    delete payloads;
+}
+
+int main() {
+    static const dispatch_strategy strategy = {
+        "06 virtual", parse, process, teardown,
+    };
+
+    return dispatch_main(&strategy);
+}
@@ -0,0 +1,379 @@
+/**
+ * @file dispatch.h
+ * @brief Harness shared by the dispatch strategy benchmarks.
+ *
+ * Every solution implements the same payload workload with a different
+ * dispatch strategy: a tagged-union switch (02), function pointers in every
+ * object (03), shared vtables (04) and C++ virtual methods (06). One driver
+ * per solution runs the corpora generated here through its parse, process
+ * and destroy phases and reports them in a common format, so the outputs of
+ * all drivers line up into one table.
+ *
+ * Instructions and branch misses are read from hardware counters through
+ * perf_event_open. Where the kernel or the virtual machine does not expose
+ * them, the columns read n/a.
+ */
+
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+
+#include <assert.h>
+#include <linux/perf_event.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/** @brief Payloads per corpus. */
+#define DISPATCH_PAYLOADS 500000
+
+/** @brief Runs per phase, the fastest one is reported. */
+#define DISPATCH_RUNS 3
+
+
+/**
+ * @brief Type mix of a corpus in percent, the rest are global messages.
+ */
+struct dispatch_mix {
+	const char *name;
+	int login;
+	int join;
+	int logout;
+	int direct;
+	int group;
+};
+
+static const struct dispatch_mix DISPATCH_MIXES[] = {
+	{ "chat",     10, 10,  5, 40, 25 },
+	{ "commands", 40, 40, 20,  0,  0 },
+	{ "messages",  0,  0,  0, 50, 30 },
+	{ "uniform",  17, 17, 16, 17, 17 },
+	{ "direct",    0,  0,  0, 100, 0 },
+};
+
+#define DISPATCH_MIX_COUNT \
+	((int) (sizeof(DISPATCH_MIXES) / sizeof(*DISPATCH_MIXES)))
+
+
+/**
+ * @brief Measurements of one phase.
+ */
+struct phase_stats {
+	double seconds;
+	uint64_t instructions;
+	uint64_t branches;
+	uint64_t branch_misses;
+	bool counted;  /**< Whether the counters above are valid */
+};
+
+enum { COUNT_INSTRUCTIONS, COUNT_BRANCHES, COUNT_BRANCH_MISSES, COUNTERS };
+
+/**
+ * @brief Hardware counters of the calling thread, -1 if unavailable.
+ */
+struct phase_counters {
+	int fds[COUNTERS];
+	double start;
+};
+
+
+static inline double dispatch_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline void open_counters(struct phase_counters *c)
+{
+	static const uint64_t configs[COUNTERS] = {
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+		PERF_COUNT_HW_BRANCH_MISSES,
+	};
+
+	for (int i = 0; i < COUNTERS; i++) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = configs[i];
+		attr.disabled = 1;
+		// user space only, allowed with perf_event_paranoid <= 2
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		c->fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+}
+
+static inline void close_counters(struct phase_counters *c)
+{
+	for (int i = 0; i < COUNTERS; i++)
+		if (c->fds[i] >= 0)
+			close(c->fds[i]);
+}
+
+static inline void start_phase(struct phase_counters *c)
+{
+	for (int i = 0; i < COUNTERS; i++)
+		if (c->fds[i] >= 0) {
+			ioctl(c->fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(c->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+
+	c->start = dispatch_now();
+}
+
+static inline struct phase_stats stop_phase(struct phase_counters *c)
+{
+	struct phase_stats stats;
+	memset(&stats, 0, sizeof(stats));
+
+	stats.seconds = dispatch_now() - c->start;
+	stats.counted = true;
+
+	uint64_t values[COUNTERS];
+
+	for (int i = 0; i < COUNTERS; i++) {
+		if (c->fds[i] < 0) {
+			stats.counted = false;
+			continue;
+		}
+
+		ioctl(c->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+		if (read(c->fds[i], &values[i], sizeof(values[i])) !=
+		    sizeof(values[i]))
+			stats.counted = false;
+	}
+
+	if (stats.counted) {
+		stats.instructions = values[COUNT_INSTRUCTIONS];
+		stats.branches = values[COUNT_BRANCHES];
+		stats.branch_misses = values[COUNT_BRANCH_MISSES];
+	}
+
+	return stats;
+}
+
+/* keeps the fastest of several runs */
+static inline void keep_best(struct phase_stats *best, struct phase_stats run)
+{
+	if (best->seconds == 0 || run.seconds < best->seconds)
+		*best = run;
+}
+
+
+/**
+ * @brief Generates count newline-terminated payloads of the given mix.
+ *
+ * Every line is a valid payload shorter than 128 bytes, which every
+ * solution can parse. Equal seeds give equal corpora.
+ *
+ * @param len Output for the size of the corpus in bytes
+ */
+static inline char *dispatch_corpus(int count, struct dispatch_mix mix,
+				    unsigned seed, size_t *len)
+{
+	static const char *users[] = {
+		"alice", "bob", "carol", "dave", "erin", "frank", "grace",
+		"heidi", "ivan", "judy", "mallory", "niaj", "olivia", "peggy",
+	};
+	static const char *channels[] = {
+		"general", "random", "announcements", "dev", "ops", "music",
+	};
+	static const char *contents[] = {
+		"hi", "How are you doing?", "Server maintenance tonight",
+		"Check this out! https://example.com/some/long/link",
+		"see you all later, I am heading out for the day",
+	};
+
+#define PICK(pool) pool[rand() % (sizeof(pool) / sizeof(*pool))]
+
+	char *corpus = (char *) malloc((size_t) count * 128 + 1);
+	assert(corpus);
+
+	size_t pos = 0;
+	srand(seed);
+
+	for (int i = 0; i < count; i++) {
+		int kind = rand() % 100;
+		char *line = corpus + pos;
+
+		if ((kind -= mix.login) < 0)
+			pos += sprintf(line, "/login %s pass%d\n", PICK(users),
+				       rand() % 1000);
+		else if ((kind -= mix.join) < 0)
+			pos += sprintf(line, "/join %s\n", PICK(channels));
+		else if ((kind -= mix.logout) < 0)
+			pos += sprintf(line, "/logout\n");
+		else if ((kind -= mix.direct) < 0)
+			pos += sprintf(line, "@%s %s\n", PICK(users),
+				       PICK(contents));
+		else if ((kind -= mix.group) < 0)
+			pos += sprintf(line, "#%s %s\n", PICK(channels),
+				       PICK(contents));
+		else
+			pos += sprintf(line, "%s\n", PICK(contents));
+	}
+
+#undef PICK
+
+	*len = pos;
+
+	return corpus;
+}
+
+/**
+ * @brief Splits a corpus into NUL-terminated lines, in place.
+ *
+ * For the solutions that parse one C string at a time.
+ *
+ * @return Array of count line pointers into corpus
+ */
+static inline char **dispatch_lines(char *corpus, size_t len, int count)
+{
+	char **lines = (char **) malloc(count * sizeof(char *));
+	assert(lines);
+
+	char *line = corpus;
+
+	for (int i = 0; i < count; i++) {
+		char *newline = (char *) memchr(line, '\n',
+						corpus + len - line);
+		assert(newline);
+
+		*newline = '\0';
+		lines[i] = line;
+		line = newline + 1;
+	}
+
+	return lines;
+}
+
+/**
+ * @brief Sends the output of the behaviors to /dev/null.
+ *
+ * Processing prints, which is part of what is measured, the same way for
+ * every strategy. Results are reported on stderr.
+ */
+static inline void silence_stdout(void)
+{
+	if (freopen("/dev/null", "w", stdout) == NULL) {
+		perror("/dev/null");
+		exit(EXIT_FAILURE);
+	}
+}
+
+static inline void report_header(void)
+{
+	fprintf(stderr, "%-10s %-9s %-8s %11s %12s %11s %12s\n",
+		"strategy", "mix", "phase", "ns/payload", "instr/payld",
+		"branch/pld", "branch-miss%");
+}
+
+static inline void report_phase(const char *strategy, const char *mix,
+				const char *phase, struct phase_stats s,
+				int payloads)
+{
+	fprintf(stderr, "%-10s %-9s %-8s %11.1f ", strategy, mix, phase,
+		s.seconds * 1e9 / payloads);
+
+	if (s.counted)
+		fprintf(stderr, "%12.1f %11.1f %11.2f%%\n",
+			(double) s.instructions / payloads,
+			(double) s.branches / payloads,
+			s.branches ? 100.0 * s.branch_misses / s.branches : 0);
+	else
+		fprintf(stderr, "%12s %11s %12s\n", "n/a", "n/a", "n/a");
+}
+
+
+/**
+ * @brief One dispatch strategy, as seen by the harness.
+ */
+struct dispatch_strategy {
+	const char *name;
+
+	/* parses the corpus, given both as a whole and split into lines, and
+	 * returns the payload buffer */
+	void *(*parse)(const char *corpus, size_t len, char **lines,
+		       int count);
+	void (*process)(void *buf);
+	void (*destroy)(void *buf);
+};
+
+/**
+ * @brief Runs every mix through the phases of strategy and reports them.
+ */
+static inline int dispatch_main(const struct dispatch_strategy *strategy)
+{
+	struct phase_counters counters;
+	open_counters(&counters);
+
+	silence_stdout();
+	report_header();
+
+	for (int m = 0; m < DISPATCH_MIX_COUNT; m++) {
+		size_t len;
+		char *corpus = dispatch_corpus(DISPATCH_PAYLOADS,
+					       DISPATCH_MIXES[m], m, &len);
+
+		// the line-based parsers get a copy split into C strings
+		char *copy = (char *) malloc(len);
+		assert(copy);
+		memcpy(copy, corpus, len);
+		char **lines = dispatch_lines(copy, len, DISPATCH_PAYLOADS);
+
+		struct phase_stats parse, process, destroy;
+		memset(&parse, 0, sizeof(parse));
+		memset(&process, 0, sizeof(process));
+		memset(&destroy, 0, sizeof(destroy));
+
+		for (int r = 0; r < DISPATCH_RUNS; r++) {
+			start_phase(&counters);
+			void *buf = strategy->parse(corpus, len, lines,
+						    DISPATCH_PAYLOADS);
+			keep_best(&parse, stop_phase(&counters));
+
+			start_phase(&counters);
+			strategy->process(buf);
+			fflush(stdout);
+			keep_best(&process, stop_phase(&counters));
+
+			start_phase(&counters);
+			strategy->destroy(buf);
+			keep_best(&destroy, stop_phase(&counters));
+		}
+
+		const char *mix = DISPATCH_MIXES[m].name;
+		report_phase(strategy->name, mix, "parse", parse,
+			     DISPATCH_PAYLOADS);
+		report_phase(strategy->name, mix, "process", process,
+			     DISPATCH_PAYLOADS);
+		report_phase(strategy->name, mix, "destroy", destroy,
+			     DISPATCH_PAYLOADS);
+
+		free(lines);
+		free(copy);
+		free(corpus);
+	}
+
+	close_counters(&counters);
+
+	return EXIT_SUCCESS;
+}
+
+
+#endif
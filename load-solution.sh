@@ -29,7 +29,7 @@ echo "Cleaning workspace and loading: $target_path"
 
 rm -rf workspace/
 cp -r "$template_dir/" workspace/
-rm -rf workspace/src/ workspace/tests/
+rm -rf workspace/src/ workspace/tests/ workspace/benches/
 
 if [ -d "$target_path/src/" ]; then
     cp -r "$target_path/src/" workspace/
@@ -39,4 +39,8 @@ if [ -d "$target_path/tests/" ]; then
     cp -r "$target_path/tests/" workspace/
 fi
 
+if [ -d "$target_path/benches/" ]; then
+    cp -r "$target_path/benches/" workspace/
+fi
+
 echo "Successfully loaded $1 into the workspace."
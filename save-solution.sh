@@ -30,4 +30,9 @@ if [ -d "workspace/tests/" ]; then
     cp -r workspace/tests/ "$target_path/"
 fi
 
+if [ -d "workspace/benches/" ]; then
+    rm -rf "$target_path/benches/"
+    cp -r workspace/benches/ "$target_path/"
+fi
+
 echo "Solution saved successfully."
@@ -0,0 +1,109 @@
+/**
+ * @file bench.h
+ * @brief Helpers shared by the benchmarks: a clock and a synthetic corpus.
+ */
+
+
+#ifndef BENCH_H
+#define BENCH_H
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+/* Type mix of a generated corpus in percent, the rest are global messages */
+struct corpus_mix {
+	int login;
+	int join;
+	int logout;
+	int direct;
+	int group;
+};
+
+static const struct corpus_mix DEFAULT_MIX = {
+	.login = 10, .join = 10, .logout = 5, .direct = 40, .group = 25,
+};
+
+
+static inline double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Generates newline-separated payloads, about len bytes of them.
+ *
+ * Every line is a whole, valid payload. Names repeat from small pools, like
+ * they do in real traffic.
+ *
+ * @param len Upper bound for the size of the corpus
+ * @param mix Share of every payload type
+ * @param seed Seed of the generator, equal seeds give equal corpora
+ * @param corpus_len Output for the actual size of the corpus
+ */
+static inline char *generate_corpus(size_t len, struct corpus_mix mix,
+				    unsigned seed, size_t *corpus_len)
+{
+	static const char *users[] = {
+		"alice", "bob", "carol", "dave", "erin", "frank", "grace",
+		"heidi", "ivan", "judy", "mallory", "niaj", "olivia", "peggy",
+	};
+	static const char *channels[] = {
+		"general", "random", "announcements", "dev", "ops", "music",
+	};
+	static const char *contents[] = {
+		"hi", "How are you doing?", "Server maintenance tonight",
+		"Check this out! https://example.com/some/long/link",
+		"see you all later, I am heading out for the day",
+	};
+
+#define PICK(pool) pool[rand() % (sizeof(pool) / sizeof(*pool))]
+
+	// no generated line is longer than this
+	const size_t max_line = 128;
+
+	char *corpus = malloc(len);
+	assert(corpus && len >= max_line);
+
+	size_t pos = 0;
+	srand(seed);
+
+	while (pos + max_line <= len) {
+		int kind = rand() % 100;
+		char *line = corpus + pos;
+		int n;
+
+		if ((kind -= mix.login) < 0)
+			n = sprintf(line, "/login %s pass%d\n", PICK(users),
+				    rand() % 1000);
+		else if ((kind -= mix.join) < 0)
+			n = sprintf(line, "/join %s\n", PICK(channels));
+		else if ((kind -= mix.logout) < 0)
+			n = sprintf(line, "/logout\n");
+		else if ((kind -= mix.direct) < 0)
+			n = sprintf(line, "@%s %s\n", PICK(users),
+				    PICK(contents));
+		else if ((kind -= mix.group) < 0)
+			n = sprintf(line, "#%s #%s %s\n", PICK(channels),
+				    PICK(channels), PICK(contents));
+		else
+			n = sprintf(line, "%s\n", PICK(contents));
+
+		pos += n;
+	}
+
+#undef PICK
+
+	*corpus_len = pos;
+
+	return corpus;
+}
+
+
+#endif
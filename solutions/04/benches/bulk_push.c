@@ -0,0 +1,113 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/payload_file.h"
+#include "../src/structural_index.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+#define CORPUS_SIZE ((size_t) 256 << 20)
+
+
+enum strategy {
+	LINE_BY_LINE,
+	BULK,
+	RESERVED_BULK,
+};
+
+static const char *const LABELS[] = {
+	[LINE_BY_LINE] = "line by line",
+	[BULK] = "bulk",
+	[RESERVED_BULK] = "reserved, bulk",
+};
+
+
+static long max_rss_kb()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	return usage.ru_maxrss;
+}
+
+static void ingest(struct payload_buffer *buf, const struct payload_file *file,
+		   enum strategy strategy)
+{
+	struct structural_index idx = { .marks = NULL };
+	const char *block;
+	size_t block_len, cursor = 0;
+
+	if (strategy == RESERVED_BULK)
+		reserve_payloads(buf, count_lines(file));
+
+	while (next_block(file, &cursor, &block, &block_len)) {
+		if (strategy != LINE_BY_LINE) {
+			push_payloads_bulk(buf, block, block_len);
+			continue;
+		}
+
+		build_structural_index(&idx, block, block_len);
+
+		for (size_t i = 0; i < idx.line_count; i++) {
+			struct payload_line line;
+			indexed_line(&idx, block, i, &line);
+
+			if (line.start != line.end)
+				push_payload(buf, &line);
+		}
+	}
+
+	free_structural_index(&idx);
+}
+
+/* runs in a child, so every run starts from the same peak memory */
+static void run(const struct payload_file *file, enum strategy strategy)
+{
+	fflush(stdout);
+
+	pid_t pid = fork();
+	assert(pid >= 0);
+
+	if (pid > 0) {
+		waitpid(pid, NULL, 0);
+		return;
+	}
+
+	struct payload_buffer *buf = new_buffer();
+
+	long rss = max_rss_kb();
+	double start = now();
+	ingest(buf, file, strategy);
+	double elapsed = now() - start;
+
+	printf("%-16s %12.1f %14ld %12.2f\n", LABELS[strategy],
+	       elapsed * 1e9 / buf->len, max_rss_kb() - rss,
+	       (double) buf->cap / buf->len);
+
+	destroy(buf);
+	fflush(stdout);
+
+	_exit(EXIT_SUCCESS);
+}
+
+int main()
+{
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	printf("%-16s %12s %14s %12s\n", "push", "ns/payload", "peak KiB added",
+	       "cap / len");
+
+	for (int s = LINE_BY_LINE; s <= RESERVED_BULK; s++)
+		run(&corpus, s);
+
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+#include "bench.h"
+#include "../src/channel_registry.h"
+#include "../src/intern.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define MEMBERS 100000
+#define RUNS 20
+
+
+static uint64_t visited;
+
+static void visit(const char *user, void *ctx)
+{
+	(void) ctx;
+	visited += (uintptr_t) user & 1;
+	visited++;
+}
+
+/* members of a channel as one random sample of the users, plus fan-out and
+ * intersection against a channel of every tenth user */
+int main()
+{
+	const char **users = malloc(MEMBERS * 4 * sizeof(*users));
+	assert(users);
+
+	char name[32];
+	for (int i = 0; i < MEMBERS * 4; i++)
+		users[i] = intern(name, sprintf(name, "user%d", i));
+
+	const char *sparse = intern("sparse", 6), *dense = intern("dense", 5);
+	const char *tenth = intern("tenth", 5);
+
+	srand(1);
+
+	double start = now();
+	for (int i = 0; i < MEMBERS; i++) {
+		join_channel(dense, users[i]);
+		join_channel(sparse, users[rand() % (MEMBERS * 4)]);
+	}
+	double join = (now() - start) * 1e9 / (2 * MEMBERS);
+
+	for (int i = 0; i < MEMBERS * 4; i += 10)
+		join_channel(tenth, users[i]);
+
+	printf("join: %.1f ns per member\n\n", join);
+	printf("per member  %8s %8s %10s %10s\n", "members", "bytes",
+	       "fan-out ns", "and ns");
+
+	const char *channels[] = { dense, sparse };
+	for (int c = 0; c < 2; c++) {
+		double fan_out = 1e30, and = 1e30;
+
+		for (int r = 0; r < RUNS; r++) {
+			start = now();
+			for_each_member(channels[c], visit, NULL);
+			double t = now() - start;
+			fan_out = t < fan_out ? t : fan_out;
+
+			start = now();
+			visited += shared_members(channels[c], tenth);
+			t = now() - start;
+			and = t < and ? t : and;
+		}
+
+		uint64_t size = channel_size(channels[c]);
+
+		printf("%-11s %8lu %8.2f %10.2f %10.2f\n",
+		       c ? "sparse" : "dense", size,
+		       (double) channel_bytes(channels[c]) / size,
+		       fan_out * 1e9 / size, and * 1e9 / size);
+	}
+
+	clear_channel_registry();
+	free(users);
+
+	return visited ? EXIT_SUCCESS : EXIT_FAILURE;
+}
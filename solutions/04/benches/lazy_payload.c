@@ -0,0 +1,115 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/lazy_payload.h"
+#include "../src/payload.h"
+#include "../src/payload_file.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+
+#define CORPUS_SIZE ((size_t) 256 << 20)
+#define RUNS 3
+
+
+/* counts global messages, or processes every payload */
+static int run_eager(const struct payload_file *file, bool process)
+{
+	struct payload_buffer *buf = new_buffer();
+	const char *block;
+	size_t block_len, cursor = 0;
+
+	while (next_block(file, &cursor, &block, &block_len))
+		push_payloads_bulk(buf, block, block_len);
+
+	int result = 0;
+
+	if (process) {
+		while (buf->process_base < buf->len)
+			process_next(buf);
+		result = buf->len;
+	} else {
+		for (int i = 0; i < buf->len; i++) {
+			const struct payload *p = &buf->payloads[i];
+
+			result += p->vtable == &message_vtable &&
+				message_receivers(&p->data)->vtable ==
+				&global_message_vtable;
+		}
+	}
+
+	destroy(buf);
+	return result;
+}
+
+static int run_lazy(const struct payload_file *file, bool process)
+{
+	struct lazy_payload_buffer *buf = lazy_new_buffer();
+	const char *block;
+	size_t block_len, cursor = 0;
+
+	while (next_block(file, &cursor, &block, &block_len))
+		lazy_push_payloads(buf, block, block_len);
+
+	int result = 0;
+
+	if (process) {
+		while (buf->process_base < buf->len)
+			lazy_process_next(buf);
+		result = buf->len;
+	} else {
+		result = lazy_count(buf, LAZY_GLOBAL_MESSAGE);
+	}
+
+	lazy_destroy(buf);
+	return result;
+}
+
+static void report(const char *label, const struct payload_file *file,
+		   bool process, int (*run)(const struct payload_file *, bool),
+		   int *result)
+{
+	double best = 1e30;
+
+	for (int r = 0; r < RUNS; r++) {
+		double start = now();
+		*result = run(file, process);
+		double elapsed = now() - start;
+
+		if (elapsed < best)
+			best = elapsed;
+	}
+
+	fprintf(stderr, "%-28s %12.1f %12.1f\n", label,
+		best * 1e9 / count_lines(file), file->len / best * 1e-6);
+}
+
+int main()
+{
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	// processing prints every payload, results go to stderr instead
+	if (freopen("/dev/null", "w", stdout) == NULL) {
+		perror("/dev/null");
+		return EXIT_FAILURE;
+	}
+
+	fprintf(stderr, "%-28s %12s %12s\n", "workload", "ns/line", "MB/s");
+
+	int eager, lazy;
+
+	report("count globals, eager", &corpus, false, run_eager, &eager);
+	report("count globals, lazy", &corpus, false, run_lazy, &lazy);
+	assert(eager == lazy);
+
+	report("process all, eager", &corpus, true, run_eager, &eager);
+	report("process all, lazy", &corpus, true, run_lazy, &lazy);
+	assert(eager == lazy);
+
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/multi_ingest.h"
+#include "../src/payload_file.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define FILES 64
+#define FILE_SIZE ((size_t) 4 << 20)
+
+
+static char paths[FILES][32];
+static const char *list[FILES];
+
+
+/* evicts the files from the page cache, so reads go to the storage */
+static void drop_cache()
+{
+	for (int i = 0; i < FILES; i++) {
+		int fd = open(paths[i], O_RDONLY);
+		assert(fd >= 0);
+
+		fdatasync(fd);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+}
+
+/* one file after the other, mapped and parsed */
+static bool push_sequential(struct payload_buffer *buf)
+{
+	for (int i = 0; i < FILES; i++) {
+		struct payload_file file;
+		if (!map_payload_file(&file, list[i]))
+			return false;
+
+		reserve_payloads(buf, count_lines(&file));
+
+		const char *block;
+		size_t block_len, cursor = 0;
+
+		while (next_block(&file, &cursor, &block, &block_len))
+			push_payloads_bulk(buf, block, block_len);
+
+		unmap_payload_file(&file);
+	}
+
+	return true;
+}
+
+static void run(const char *label, int depth, bool cold,
+		bool (*push)(struct payload_buffer *, const char *const *,
+			     int, int))
+{
+	struct payload_buffer *buf = new_buffer();
+
+	if (cold)
+		drop_cache();
+
+	double start = now();
+	bool ok = push ? push(buf, list, FILES, depth) : push_sequential(buf);
+	double elapsed = now() - start;
+	assert(ok);
+
+	printf("%-10s %6d %6s %12.1f %10.1f\n", label, depth,
+	       cold ? "cold" : "warm", elapsed * 1e9 / buf->len,
+	       FILES * FILE_SIZE / elapsed * 1e-6);
+
+	destroy(buf);
+}
+
+int main()
+{
+	for (int i = 0; i < FILES; i++) {
+		size_t len;
+		char *text = generate_corpus(FILE_SIZE, DEFAULT_MIX, i, &len);
+
+		snprintf(paths[i], sizeof(paths[i]), "/tmp/ingest_benchXXXXXX");
+		int fd = mkstemp(paths[i]);
+		assert(fd >= 0);
+		[[maybe_unused]] ssize_t written = write(fd, text, len);
+		assert(written == (ssize_t) len);
+		close(fd);
+
+		list[i] = paths[i];
+		free(text);
+	}
+
+	printf("%d files of %zu MiB, io_uring %s\n", FILES, FILE_SIZE >> 20,
+	       io_uring_available() ? "available" : "not available");
+	printf("%-10s %6s %6s %12s %10s\n", "reads", "depth", "cache",
+	       "ns/payload", "MB/s");
+
+	for (int cold = 1; cold >= 0; cold--) {
+		run("sequential", 1, cold, NULL);
+
+		for (int depth = 1; depth <= 64; depth *= 8) {
+			run("threads", depth, cold, push_payload_files_threads);
+
+			if (io_uring_available())
+				run("io_uring", depth, cold,
+				    push_payload_files_uring);
+		}
+	}
+
+	for (int i = 0; i < FILES; i++)
+		remove(paths[i]);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include "bench.h"
+#include "../src/output_sink.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+#define LINES 2000000
+
+
+static const char *users[] = { "alice", "bob", "carol", "dave" };
+
+/* prints what processing a direct message prints, flushing every line */
+static double run_stdio(FILE *out, bool flush_lines)
+{
+	double start = now();
+
+	for (int i = 0; i < LINES; i++) {
+		fprintf(out, "Direct message to %s: %s\n", users[i % 4],
+			"How are you doing?");
+
+		if (flush_lines)
+			fflush(out);
+	}
+	fflush(out);
+
+	return now() - start;
+}
+
+static double run_sink(int fd, bool async, bool format)
+{
+	struct output_sink sink;
+	sink_open(&sink, fd, 0, async);
+
+	double start = now();
+
+	for (int i = 0; i < LINES; i++) {
+		if (format) {
+			sink_printf(&sink, "Direct message to %s: %s\n",
+				    users[i % 4], "How are you doing?");
+			continue;
+		}
+
+		sink_puts(&sink, "Direct message to ");
+		sink_puts(&sink, users[i % 4]);
+		sink_puts(&sink, ": ");
+		sink_puts(&sink, "How are you doing?");
+		sink_puts(&sink, "\n");
+	}
+	sink_close(&sink);
+
+	return now() - start;
+}
+
+int main()
+{
+	char path[] = "/tmp/output_sink_benchXXXXXX";
+	int fd = mkstemp(path);
+	assert(fd >= 0);
+
+	FILE *out = fdopen(dup(fd), "w");
+	assert(out);
+
+	printf("%-24s %12s %10s\n", "output to a file", "ns/line", "speedup");
+
+	double flushed = 0;
+	const char *labels[] = {
+		"stdio, flush per line", "stdio, buffered", "sink, printf",
+		"sink, puts", "async sink, printf", "async sink, puts",
+	};
+
+	for (int s = 0; s < 6; s++) {
+		[[maybe_unused]] int truncated = ftruncate(fd, 0);
+		assert(truncated == 0);
+		lseek(fd, 0, SEEK_SET);
+		fseek(out, 0, SEEK_SET);
+
+		double elapsed = s < 2 ? run_stdio(out, s == 0) :
+			run_sink(fd, s >= 4, s % 2 == 0);
+
+		if (s == 0)
+			flushed = elapsed;
+
+		printf("%-24s %12.1f %9.2fx\n", labels[s],
+		       elapsed * 1e9 / LINES, flushed / elapsed);
+	}
+
+	fclose(out);
+	close(fd);
+	remove(path);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/parallel_ingest.h"
+#include "../src/payload_file.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+#define CORPUS_SIZE ((size_t) 256 << 20)
+#define RUNS 3
+
+
+/* usage: parallel_ingest.bench [max threads], one per online CPU by default */
+int main(int argc, const char **args)
+{
+	int max_workers = argc > 1 ? atoi(args[1]) :
+		sysconf(_SC_NPROCESSORS_ONLN);
+	if (max_workers < 1)
+		max_workers = 1;
+
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	printf("corpus: %zu MiB, online CPUs: %ld\n", corpus.len >> 20,
+	       sysconf(_SC_NPROCESSORS_ONLN));
+	printf("%-8s %12s %12s %10s\n", "threads", "ns/payload", "MB/s",
+	       "speedup");
+
+	double single = 0;
+
+	for (int workers = 1; workers <= max_workers; workers++) {
+		double best = 1e30;
+		int len = 0;
+
+		for (int r = 0; r < RUNS; r++) {
+			struct payload_buffer *buf = new_buffer();
+
+			double start = now();
+			push_payloads_parallel(buf, &corpus, workers);
+			double elapsed = now() - start;
+
+			if (elapsed < best)
+				best = elapsed;
+
+			len = buf->len;
+			destroy(buf);
+		}
+
+		if (workers == 1)
+			single = best;
+
+		printf("%-8d %12.1f %12.1f %9.2fx\n", workers,
+		       best * 1e9 / len, corpus.len / best * 1e-6,
+		       single / best);
+	}
+
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
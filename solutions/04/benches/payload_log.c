@@ -0,0 +1,99 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/parallel_ingest.h"
+#include "../src/payload_file.h"
+#include "../src/payload_log.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define CORPUS_SIZE ((size_t) 64 << 20)
+#define TAIL 1000
+
+
+static char dir[] = "/tmp/payload_log_benchXXXXXX";
+
+
+static double replay_from(uint64_t from, int *len)
+{
+	struct payload_buffer *buf = new_buffer();
+
+	double start = now();
+	assert(replay_payload_log(buf, dir, from));
+	double elapsed = now() - start;
+
+	*len = buf->len;
+	destroy(buf);
+
+	return elapsed;
+}
+
+static void remove_log()
+{
+	DIR *d = opendir(dir);
+	char path[512];
+
+	for (struct dirent *entry; (entry = readdir(d)) != NULL;) {
+		if (entry->d_name[0] == '.')
+			continue;
+
+		sprintf(path, "%s/%s", dir, entry->d_name);
+		unlink(path);
+	}
+
+	closedir(d);
+	rmdir(dir);
+}
+
+/* writing the log while reading a corpus, then replaying all of it and
+ * only its tail */
+int main()
+{
+	assert(mkdtemp(dir));
+
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	struct payload_buffer *buf = new_buffer();
+
+	double start = now();
+	push_payloads_parallel(buf, &corpus, 1);
+	double plain = now() - start;
+	int count = buf->len;
+	destroy(buf);
+
+	struct payload_log log;
+	assert(open_payload_log(&log, dir, 0));
+
+	buf = new_buffer();
+	buf->log = &log;
+
+	start = now();
+	push_payloads_parallel(buf, &corpus, 1);
+	close_payload_log(&log);
+	double logged = now() - start;
+	destroy(buf);
+
+	int all_len, tail_len;
+	double all = replay_from(0, &all_len);
+	double tail = replay_from(count - TAIL, &tail_len);
+	assert(all_len == count && tail_len == TAIL);
+
+	printf("payloads: %d\n", count);
+	printf("%-28s %12s\n", "", "ns/payload");
+	printf("%-28s %12.1f\n", "read", plain * 1e9 / count);
+	printf("%-28s %12.1f\n", "read, logging", logged * 1e9 / count);
+	printf("%-28s %12.1f\n", "replay all", all * 1e9 / count);
+	printf("%-28s %12.1f us in total\n", "replay the last 1000",
+	       tail * 1e6);
+
+	remove_log();
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/payload_file.h"
+#include "../src/pipeline.h"
+#include "../src/structural_index.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+
+#define CORPUS_SIZE ((size_t) 64 << 20)
+
+
+/* parses the whole file, then processes it, as main does by default */
+static long process_sequential(const struct payload_file *file)
+{
+	struct payload_buffer *buf = new_buffer();
+	struct structural_index idx = { .marks = NULL };
+	const char *block;
+	size_t block_len, cursor = 0;
+
+	while (next_block(file, &cursor, &block, &block_len)) {
+		build_structural_index(&idx, block, block_len);
+
+		for (size_t i = 0; i < idx.line_count; i++) {
+			struct payload_line line;
+			indexed_line(&idx, block, i, &line);
+
+			if (line.start != line.end)
+				push_payload(buf, &line);
+		}
+	}
+
+	free_structural_index(&idx);
+
+	while (buf->process_base < buf->len)
+		process_next(buf);
+
+	long processed = buf->len;
+	destroy(buf);
+
+	return processed;
+}
+
+int main()
+{
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	// processing prints every payload, results go to stderr instead
+	if (freopen("/dev/null", "w", stdout) == NULL) {
+		perror("/dev/null");
+		return EXIT_FAILURE;
+	}
+
+	fprintf(stderr, "%-20s %12s %12s\n", "strategy", "ns/payload", "MB/s");
+
+	double start = now();
+	long processed = process_sequential(&corpus);
+	double elapsed = now() - start;
+
+	fprintf(stderr, "%-20s %12.1f %12.1f\n", "sequential",
+		elapsed * 1e9 / processed, corpus.len / elapsed * 1e-6);
+
+	for (size_t depth = 1; depth <= 32; depth *= 4) {
+		char label[32];
+		snprintf(label, sizeof(label), "pipelined, depth %zu", depth);
+
+		start = now();
+		processed = process_pipelined(&corpus, depth);
+		elapsed = now() - start;
+
+		fprintf(stderr, "%-20s %12.1f %12.1f\n", label,
+			elapsed * 1e9 / processed, corpus.len / elapsed * 1e-6);
+	}
+
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,182 @@
+#include "bench.h"
+#include "../src/batch_dispatch.h"
+#include "../src/payload.h"
+#include "../src/payload_file.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+
+#define CORPUS_SIZE ((size_t) 32 << 20)
+#define RUNS 5
+
+
+// The real behaviors print, and printf would drown the cost of dispatch. The
+// payloads are rewired to behaviors doing a little work on their data, with
+// the same vtable layout, so the calls stay just as indirect.
+
+static volatile unsigned long sink;
+
+static void touch(const char *str)
+{
+	sink += str ? (unsigned char) str[0] : 0;
+}
+
+static void bench_process_command_login(const struct payload *self)
+{
+	touch(self->data.command_login.username);
+	touch(self->data.command_login.password);
+}
+
+static void bench_process_command_join(const struct payload *self)
+{
+	touch(self->data.command_join.channel);
+}
+
+static void bench_process_command_logout(const struct payload *self)
+{
+	sink++;
+	(void) self;
+}
+
+static void bench_process_message(const struct payload *self)
+{
+	const struct message_receiving_entity *receivers =
+		message_receivers(&self->data);
+
+	for (int i = 0; i < self->data.message.receiver_count; i++)
+		receivers[i].vtable->transmit_message(
+			&receivers[i], self->data.message.content);
+}
+
+static void bench_transmit(const struct message_receiving_entity *self,
+			   const char *content)
+{
+	touch(self->additional_info);
+	touch(content);
+}
+
+static struct payload_vtable vtables[4];
+static const struct payload_vtable *real_vtables[4] = {
+	&command_login_vtable, &command_join_vtable, &command_logout_vtable,
+	&message_vtable,
+};
+static void (*bench_processes[4])(const struct payload *) = {
+	bench_process_command_login, bench_process_command_join,
+	bench_process_command_logout, bench_process_message,
+};
+
+static struct message_receiving_entity_vtable receiver_vtables[3];
+static const struct message_receiving_entity_vtable *
+real_receiver_vtables[3] = {
+	&direct_message_vtable, &group_message_vtable, &global_message_vtable,
+};
+
+
+static struct payload_buffer *load(const struct payload_file *corpus)
+{
+	struct payload_buffer *buf = new_buffer();
+	struct structural_index idx = { .marks = NULL };
+	const char *block;
+	size_t block_len, cursor = 0;
+
+	while (next_block(corpus, &cursor, &block, &block_len)) {
+		build_structural_index(&idx, block, block_len);
+
+		for (size_t i = 0; i < idx.line_count; i++) {
+			struct payload_line line;
+			indexed_line(&idx, block, i, &line);
+			push_payload(buf, &line);
+		}
+	}
+
+	free_structural_index(&idx);
+
+	for (int v = 0; v < 4; v++) {
+		vtables[v] = *real_vtables[v];
+		vtables[v].process = bench_processes[v];
+	}
+	for (int v = 0; v < 3; v++)
+		receiver_vtables[v].transmit_message = bench_transmit;
+
+	for (int i = 0; i < buf->len; i++) {
+		struct payload *p = &buf->payloads[i];
+
+		for (int v = 0; v < 4; v++)
+			if (p->vtable == real_vtables[v])
+				p->vtable = &vtables[v];
+
+		if (p->vtable != &vtables[3])
+			continue;
+
+		// the receivers belong to the buffer, which is ours to change
+		struct message_receiving_entity *receivers =
+			(struct message_receiving_entity *)
+			message_receivers(&p->data);
+
+		for (int r = 0; r < p->data.message.receiver_count; r++)
+			for (int v = 0; v < 3; v++)
+				if (receivers[r].vtable ==
+				    real_receiver_vtables[v])
+					receivers[r].vtable =
+						&receiver_vtables[v];
+	}
+
+	return buf;
+}
+
+/* best of RUNS, in ns per payload; window 0 means process_next */
+static double run(struct payload_buffer *buf, int window,
+		  enum batch_order order)
+{
+	double best = 1e30;
+
+	for (int r = 0; r < RUNS; r++) {
+		buf->process_base = 0;
+
+		double start = now();
+		if (window == 0)
+			while (buf->process_base < buf->len)
+				process_next(buf);
+		else
+			while (process_batch(buf, window, order));
+		double elapsed = now() - start;
+
+		if (elapsed < best)
+			best = elapsed;
+	}
+
+	return best * 1e9 / buf->len;
+}
+
+int main()
+{
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	struct payload_buffer *buf = load(&corpus);
+
+	printf("payloads: %d\n", buf->len);
+	printf("%-24s %12s\n", "mode", "ns/payload");
+	printf("%-24s %12.2f\n", "process_next", run(buf, 0, BATCH_ANY_ORDER));
+
+	static const int windows[] = { 256, 4096, 65536 };
+
+	for (size_t w = 0; w < sizeof(windows) / sizeof(*windows); w++) {
+		char name[64];
+
+		sprintf(name, "batch %d any order", windows[w]);
+		printf("%-24s %12.2f\n", name,
+		       run(buf, windows[w], BATCH_ANY_ORDER));
+
+		sprintf(name, "batch %d name order", windows[w]);
+		printf("%-24s %12.2f\n", name,
+		       run(buf, windows[w], BATCH_NAME_ORDER));
+	}
+
+	destroy(buf);
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+#include "bench.h"
+#include "../src/intern.h"
+#include "../src/session_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define USERS (1 << 21)
+#define CHURN (USERS * 4)
+
+
+/* fills the table with millions of sessions, then logs random users in and
+ * out at a steady state of about half of them online */
+int main()
+{
+	const char **users = malloc(USERS * sizeof(*users));
+	char *online = calloc(USERS, 1);
+	assert(users && online);
+
+	char name[32];
+	for (int i = 0; i < USERS; i++)
+		users[i] = intern(name, sprintf(name, "user%d", i));
+
+	double start = now();
+	for (int i = 0; i < USERS; i++) {
+		open_session(users[i]);
+		online[i] = 1;
+	}
+	double fill = now() - start;
+	size_t bytes = session_table_bytes();
+
+	srand(1);
+	int *picks = malloc(CHURN * sizeof(int));
+	assert(picks);
+	for (int i = 0; i < CHURN; i++)
+		picks[i] = ((unsigned) rand() << 16 ^ rand()) % USERS;
+
+	start = now();
+	for (int i = 0; i < CHURN; i++) {
+		int u = picks[i];
+
+		if (online[u])
+			close_session(users[u]);
+		else
+			open_session(users[u]);
+		online[u] ^= 1;
+	}
+	double churn = now() - start;
+
+	size_t hits = 0;
+	start = now();
+	for (int i = 0; i < CHURN; i++)
+		hits += is_online(users[picks[i]]);
+	double lookup = now() - start;
+
+	printf("sessions: %d, table: %.1f MiB, %.1f bytes per session\n",
+	       USERS, bytes / 1048576.0, (double) bytes / USERS);
+	printf("%-24s %10s\n", "operation", "ns/op");
+	printf("%-24s %10.1f\n", "login (filling)", fill * 1e9 / USERS);
+	printf("%-24s %10.1f\n", "login/logout churn", churn * 1e9 / CHURN);
+	printf("%-24s %10.1f\n", "lookup", lookup * 1e9 / CHURN);
+	printf("online after churn: %zu, hits: %zu\n", online_count(), hits);
+
+	clear_session_table();
+	free(picks);
+	free(online);
+	free(users);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/payload.h"
+#include "../src/payload_file.h"
+#include "../src/soa_buffer.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+
+#define CORPUS_SIZE ((size_t) 64 << 20)
+#define RUNS 10
+
+
+static volatile int sink;
+
+int main()
+{
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	struct payload_buffer *aos = new_buffer();
+	struct soa_payload_buffer *soa = soa_new_buffer();
+	struct structural_index idx = { .marks = NULL };
+	const char *block;
+	size_t block_len, cursor = 0;
+
+	while (next_block(&corpus, &cursor, &block, &block_len)) {
+		build_structural_index(&idx, block, block_len);
+
+		for (size_t i = 0; i < idx.line_count; i++) {
+			struct payload_line line;
+			indexed_line(&idx, block, i, &line);
+
+			push_payload(aos, &line);
+			soa_push_payload(soa, &line);
+		}
+	}
+
+	free_structural_index(&idx);
+
+	// counting messages is a type-only pass
+	double aos_best = 1e30, soa_best = 1e30;
+
+	for (int r = 0; r < RUNS; r++) {
+		double start = now();
+		int count = 0;
+		for (int i = 0; i < aos->len; i++)
+			count += aos->payloads[i].vtable == &message_vtable;
+		sink = count;
+		double elapsed = now() - start;
+
+		if (elapsed < aos_best)
+			aos_best = elapsed;
+
+		start = now();
+		sink = soa_count(soa, &message_vtable);
+		elapsed = now() - start;
+
+		if (elapsed < soa_best)
+			soa_best = elapsed;
+	}
+
+	printf("payloads: %d\n", aos->len);
+	printf("%-20s %12s %12s\n", "count messages", "ns/payload", "GB/s");
+	printf("%-20s %12.3f %12.2f\n", "array of structs",
+	       aos_best * 1e9 / aos->len,
+	       aos->len * sizeof(struct payload) / aos_best * 1e-9);
+	printf("%-20s %12.3f %12.2f\n", "struct of arrays",
+	       soa_best * 1e9 / soa->len,
+	       soa->len * sizeof(*soa->vtables) / soa_best * 1e-9);
+
+	soa_destroy(soa);
+	destroy(aos);
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/payload_file.h"
+#include "../src/structural_index.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+#define CORPUS_SIZE ((size_t) 128 << 20)
+
+
+static long max_rss_kb()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	return usage.ru_maxrss;
+}
+
+/* pushes every payload of the file and processes it, holding at most
+ * high_water of them unless it is 0; a full buffer is drained whole, or
+ * makes room for one payload at a time */
+static long process_file(const struct payload_file *file, int high_water,
+			 bool drain)
+{
+	struct payload_buffer *buf = new_buffer();
+	if (high_water > 0)
+		stream_buffer(buf, high_water);
+
+	struct structural_index idx = { .marks = NULL };
+	const char *block;
+	size_t block_len, cursor = 0;
+
+	while (next_block(file, &cursor, &block, &block_len)) {
+		build_structural_index(&idx, block, block_len);
+
+		for (size_t i = 0; i < idx.line_count; i++) {
+			struct payload_line line;
+			indexed_line(&idx, block, i, &line);
+
+			if (line.start == line.end)
+				continue;
+
+			if (buffer_full(buf))
+				do
+					process_next(buf);
+				while (drain && buf->process_base < buf->len);
+
+			push_payload(buf, &line);
+		}
+	}
+
+	free_structural_index(&idx);
+
+	while (buf->process_base < buf->len)
+		process_next(buf);
+
+	long processed = buf->dropped + buf->len;
+	destroy(buf);
+
+	return processed;
+}
+
+/* runs in a child, so every run starts from the same peak memory */
+static void run(const struct payload_file *file, int high_water, bool drain)
+{
+	fflush(stderr);
+
+	pid_t pid = fork();
+	assert(pid >= 0);
+
+	if (pid > 0) {
+		waitpid(pid, NULL, 0);
+		return;
+	}
+
+	long rss = max_rss_kb();
+	double start = now();
+	long processed = process_file(file, high_water, drain);
+	double elapsed = now() - start;
+
+	char label[32];
+	if (high_water > 0)
+		snprintf(label, sizeof(label), "streaming, %d%s", high_water,
+			 drain ? "" : ", 1 by 1");
+	else
+		snprintf(label, sizeof(label), "unbounded");
+
+	fprintf(stderr, "%-28s %12.1f %14ld\n", label,
+		elapsed * 1e9 / processed, max_rss_kb() - rss);
+
+	_exit(EXIT_SUCCESS);
+}
+
+int main()
+{
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	// processing prints every payload, results go to stderr instead
+	if (freopen("/dev/null", "w", stdout) == NULL) {
+		perror("/dev/null");
+		return EXIT_FAILURE;
+	}
+
+	fprintf(stderr, "%-28s %12s %14s\n", "buffer", "ns/payload",
+		"peak KiB added");
+
+	run(&corpus, 0, true);
+
+	for (int high_water = 256; high_water <= 65536; high_water *= 16) {
+		run(&corpus, high_water, true);
+		run(&corpus, high_water, false);
+	}
+
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
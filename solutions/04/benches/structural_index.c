@@ -0,0 +1,164 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/payload_file.h"
+#include "../src/structural_index.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+
+#define CORPUS_SIZE ((size_t) 64 << 20)
+#define RUNS 5
+
+
+typedef void (*index_builder)(struct structural_index *idx, const char *block,
+			      size_t len);
+
+
+/* best of RUNS, in GB/s, for indexing every block of the corpus */
+static double index_throughput(index_builder build,
+			       const struct payload_file *corpus)
+{
+	struct structural_index idx = { .marks = NULL };
+	double best = 0;
+
+	for (int run = 0; run < RUNS; run++) {
+		const char *block;
+		size_t block_len, cursor = 0;
+
+		double start = now();
+		while (next_block(corpus, &cursor, &block, &block_len))
+			build(&idx, block, block_len);
+		double elapsed = now() - start;
+
+		if (corpus->len / elapsed > best)
+			best = corpus->len / elapsed;
+	}
+
+	free_structural_index(&idx);
+
+	return best * 1e-9;
+}
+
+/* GB/s of indexing and parsing the corpus into a payload buffer */
+static double parse_throughput(index_builder build,
+			       const struct payload_file *corpus)
+{
+	struct structural_index idx = { .marks = NULL };
+	double best = 0;
+
+	for (int run = 0; run < RUNS; run++) {
+		struct payload_buffer *buf = new_buffer();
+		const char *block;
+		size_t block_len, cursor = 0;
+
+		double start = now();
+		while (next_block(corpus, &cursor, &block, &block_len)) {
+			build(&idx, block, block_len);
+
+			for (size_t i = 0; i < idx.line_count; i++) {
+				struct payload_line line;
+				indexed_line(&idx, block, i, &line);
+				push_payload(buf, &line);
+			}
+		}
+		double elapsed = now() - start;
+
+		if (corpus->len / elapsed > best)
+			best = corpus->len / elapsed;
+
+		destroy(buf);
+	}
+
+	free_structural_index(&idx);
+
+	return best * 1e-9;
+}
+
+/* GB/s of the old line loop, fgets and strlen over the corpus as a stream,
+ * and when parsing each line indexed on its own and pushed */
+static double fgets_throughput(const struct payload_file *corpus, bool parse)
+{
+	struct structural_index idx = { .marks = NULL };
+	double best = 0;
+
+	for (int run = 0; run < RUNS; run++) {
+		struct payload_buffer *buf = new_buffer();
+		FILE *file = fmemopen((char *) corpus->data, corpus->len, "r");
+		assert(file);
+
+		char text[1024];
+		double start = now();
+		while (fgets(text, sizeof(text), file) != NULL) {
+			size_t len = strlen(text);
+			if (len < 2)
+				continue;
+
+			// nothing is cut at the line limit
+			assert(text[len - 1] == '\n');
+			text[--len] = '\0';
+
+			if (!parse)
+				continue;
+
+			struct payload_line line;
+			build_structural_index_scalar(&idx, text, len);
+			indexed_line(&idx, text, 0, &line);
+			push_payload(buf, &line);
+		}
+		double elapsed = now() - start;
+
+		if (corpus->len / elapsed > best)
+			best = corpus->len / elapsed;
+
+		fclose(file);
+		destroy(buf);
+	}
+
+	free_structural_index(&idx);
+
+	return best * 1e-9;
+}
+
+int main()
+{
+	static const struct {
+		const char *name;
+		index_builder build;
+	} builders[] = {
+		{ "scalar", build_structural_index_scalar },
+#if defined(__x86_64__) || defined(__i386__)
+		{ "sse2", build_structural_index_sse2 },
+		{ "avx2", build_structural_index_avx2 },
+#endif
+	};
+
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	printf("corpus: %zu MiB\n", corpus.len >> 20);
+	printf("%-8s %12s %12s\n", "builder", "index GB/s", "parse GB/s");
+
+	// the baseline, before lines were found a block at a time
+	printf("%-8s %12.2f %12.2f\n", "fgets", fgets_throughput(&corpus, false),
+	       fgets_throughput(&corpus, true));
+
+	for (size_t i = 0; i < sizeof(builders) / sizeof(*builders); i++) {
+#if defined(__x86_64__) || defined(__i386__)
+		if (builders[i].build == build_structural_index_avx2 &&
+		    !__builtin_cpu_supports("avx2"))
+			continue;
+#endif
+
+		printf("%-8s %12.2f %12.2f\n", builders[i].name,
+		       index_throughput(builders[i].build, &corpus),
+		       parse_throughput(builders[i].build, &corpus));
+	}
+
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/parallel_ingest.h"
+#include "../src/payload_file.h"
+#include "../src/wire_format.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define CORPUS_SIZE ((size_t) 64 << 20)
+#define RUNS 3
+
+
+/* the same corpus loaded from text and from its encoding */
+int main()
+{
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	double text = 1e30, encode = 1e30, decode = 1e30;
+	int count = 0;
+	size_t encoded_len = 0;
+
+	for (int r = 0; r < RUNS; r++) {
+		struct payload_buffer *parsed = new_buffer();
+
+		double start = now();
+		push_payloads_parallel(parsed, &corpus, 1);
+		double elapsed = now() - start;
+		text = elapsed < text ? elapsed : text;
+		count = parsed->len;
+
+		start = now();
+		char *encoded = serialize_payloads(parsed->payloads,
+						   parsed->len, &encoded_len);
+		elapsed = now() - start;
+		encode = elapsed < encode ? elapsed : encode;
+
+		struct payload_buffer *decoded = new_buffer();
+
+		start = now();
+		bool valid = deserialize_payloads(decoded, encoded,
+						  encoded_len);
+		elapsed = now() - start;
+		decode = elapsed < decode ? elapsed : decode;
+
+		assert(valid && decoded->len == parsed->len);
+
+		free(encoded);
+		destroy(decoded);
+		destroy(parsed);
+	}
+
+	printf("payloads: %d, text: %zu MiB, encoded: %zu MiB\n", count,
+	       corpus.len >> 20, encoded_len >> 20);
+	printf("%-12s %12s %10s\n", "", "ns/payload", "speedup");
+	printf("%-12s %12.1f %9.2fx\n", "parse text", text * 1e9 / count, 1.0);
+	printf("%-12s %12.1f\n", "encode", encode * 1e9 / count);
+	printf("%-12s %12.1f %9.2fx\n", "decode", decode * 1e9 / count,
+	       text / decode);
+
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+#include "bench.h"
+#include "../src/dynamic_dispatch.h"
+#include "../src/parallel_ingest.h"
+#include "../src/payload.h"
+#include "../src/payload_file.h"
+#include "../src/work_stealing.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+#define CORPUS_SIZE ((size_t) 4 << 20)
+
+/* rounds of hashing standing in for real delivery work, a few microseconds */
+#define DELIVERY_ROUNDS 1000
+
+
+// Delivery is meant to be far heavier than the printf the real behaviors do.
+// Every payload is rewired to a behavior hashing its first string over and
+// over, and nothing is printed.
+
+static atomic_ulong sink;
+
+static void deliver(const struct payload *self)
+{
+	const char *str = self->vtable->name ? self->vtable->name(self, 0) :
+		NULL;
+	unsigned long h = 5381;
+
+	for (int r = 0; r < DELIVERY_ROUNDS; r++)
+		for (const char *c = str ? str : "all"; *c; c++)
+			h = h * 33 + *c;
+
+	atomic_fetch_add_explicit(&sink, h, memory_order_relaxed);
+}
+
+static struct payload_vtable vtables[4];
+static const struct payload_vtable *real_vtables[4] = {
+	&command_login_vtable, &command_join_vtable, &command_logout_vtable,
+	&message_vtable,
+};
+
+
+static struct payload_buffer *load(const struct payload_file *corpus)
+{
+	struct payload_buffer *buf = new_buffer();
+	push_payloads_parallel(buf, corpus, 1);
+
+	for (int i = 0; i < buf->len; i++)
+		for (int v = 0; v < 4; v++)
+			if (buf->payloads[i].vtable == real_vtables[v])
+				buf->payloads[i].vtable = &vtables[v];
+
+	return buf;
+}
+
+/* usage: work_stealing.bench [max threads], one per online CPU by default */
+int main(int argc, const char **args)
+{
+	int max_workers = argc > 1 ? atoi(args[1]) :
+		sysconf(_SC_NPROCESSORS_ONLN);
+	if (max_workers < 1)
+		max_workers = 1;
+
+	for (int v = 0; v < 4; v++) {
+		vtables[v] = *real_vtables[v];
+		vtables[v].process = deliver;
+	}
+
+	struct payload_file corpus;
+	corpus.data = generate_corpus(CORPUS_SIZE, DEFAULT_MIX, 0,
+				      &corpus.len);
+
+	printf("online CPUs: %ld\n", sysconf(_SC_NPROCESSORS_ONLN));
+	printf("%-20s %12s %10s\n", "strategy", "ns/payload", "speedup");
+
+	struct payload_buffer *buf = load(&corpus);
+
+	double start = now();
+	while (buf->process_base < buf->len)
+		process_next(buf);
+	double sequential = now() - start;
+
+	printf("%-20s %12.1f %9.2fx\n", "process_next",
+	       sequential * 1e9 / buf->len, 1.0);
+	destroy(buf);
+
+	for (int workers = 1; workers <= max_workers; workers++) {
+		buf = load(&corpus);
+
+		start = now();
+		process_parallel(buf, workers);
+		double elapsed = now() - start;
+
+		char label[32];
+		snprintf(label, sizeof(label), "%d workers", workers);
+		printf("%-20s %12.1f %9.2fx\n", label,
+		       elapsed * 1e9 / buf->len, sequential / elapsed);
+
+		destroy(buf);
+	}
+
+	free((char *) corpus.data);
+
+	return EXIT_SUCCESS;
+}
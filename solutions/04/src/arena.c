@@ -0,0 +1,120 @@
+#include "arena.h"
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* chunks double in size up to this limit, bigger allocations get their own
+ * chunk */
+#define ARENA_MIN_CHUNK ((size_t) 4096)
+#define ARENA_MAX_CHUNK ((size_t) 1 << 20)
+
+
+struct arena_chunk {
+	struct arena_chunk *prev;
+	size_t cap;
+	size_t used;
+	alignas(max_align_t) char data[];
+};
+
+
+static struct arena_chunk *new_chunk(struct arena_chunk *prev, size_t min_cap)
+{
+	size_t cap = prev ? prev->cap * 2 : ARENA_MIN_CHUNK;
+
+	if (cap > ARENA_MAX_CHUNK)
+		cap = ARENA_MAX_CHUNK;
+	if (cap < min_cap)
+		cap = min_cap;
+
+	struct arena_chunk *chunk = malloc(sizeof(struct arena_chunk) + cap);
+	assert(chunk);
+
+	chunk->prev = prev;
+	chunk->cap = cap;
+	chunk->used = 0;
+
+	return chunk;
+}
+
+void *arena_alloc(struct arena *a, size_t size, size_t align)
+{
+	struct arena_chunk *chunk = a->chunks;
+
+	if (chunk != NULL) {
+		size_t offset = (chunk->used + align - 1) & ~(align - 1);
+
+		if (offset + size <= chunk->cap) {
+			chunk->used = offset + size;
+
+			return chunk->data + offset;
+		}
+	}
+
+	// chunk data is aligned to max_align_t, no padding needed up front
+	chunk = a->chunks = new_chunk(chunk, size);
+	chunk->used = size;
+
+	return chunk->data;
+}
+
+char *arena_strndup(struct arena *a, const char *src, size_t len)
+{
+	char *str = arena_alloc(a, len + 1, 1);
+
+	memcpy(str, src, len);
+	str[len] = '\0';
+
+	return str;
+}
+
+struct arena_mark arena_save(const struct arena *a)
+{
+	return (struct arena_mark) {
+		.chunk = a->chunks,
+		.used = a->chunks ? a->chunks->used : 0,
+	};
+}
+
+void arena_rollback(struct arena *a, struct arena_mark mark)
+{
+	while (a->chunks != mark.chunk) {
+		struct arena_chunk *prev = a->chunks->prev;
+		free(a->chunks);
+		a->chunks = prev;
+	}
+
+	if (a->chunks != NULL)
+		a->chunks->used = mark.used;
+}
+
+void arena_adopt(struct arena *dst, struct arena *src)
+{
+	struct arena_chunk *oldest = src->chunks;
+
+	if (oldest == NULL)
+		return;
+
+	while (oldest->prev != NULL)
+		oldest = oldest->prev;
+
+	// the newest chunk of src becomes the one dst allocates from next
+	oldest->prev = dst->chunks;
+	dst->chunks = src->chunks;
+	src->chunks = NULL;
+}
+
+void arena_release(struct arena *a)
+{
+	struct arena_chunk *chunk = a->chunks;
+
+	while (chunk != NULL) {
+		struct arena_chunk *prev = chunk->prev;
+		free(chunk);
+		chunk = prev;
+	}
+
+	a->chunks = NULL;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file arena.h
+ * @brief Bump allocator that owns every string of a payload buffer.
+ *
+ * Allocations are carved out of large chunks by moving a cursor forward.
+ * Individual allocations are never freed; the whole arena is released at
+ * once, which turns teardown of millions of payloads into a few free calls.
+ */
+
+
+#ifndef ARENA_H
+#define ARENA_H
+
+
+#include <stddef.h>
+
+
+/**
+ * @brief Chunk list of a bump allocator. Zero-initialize before first use.
+ */
+struct arena {
+	struct arena_chunk *chunks;  /**< Most recently allocated chunk */
+};
+
+/**
+ * @brief Position of the cursor of an arena, to roll back to.
+ */
+struct arena_mark {
+	struct arena_chunk *chunk;
+	size_t used;
+};
+
+
+/**
+ * @brief Allocates size bytes aligned to align, which must be a power of 2.
+ *
+ * Never returns NULL; an allocation failure raises an assertion like every
+ * other allocation in this project.
+ */
+void *arena_alloc(struct arena *a, size_t size, size_t align);
+
+/**
+ * @brief Copies len bytes of src into the arena and NUL-terminates them.
+ */
+char *arena_strndup(struct arena *a, const char *src, size_t len);
+
+/**
+ * @brief Moves every allocation of src into dst.
+ *
+ * Allocations keep their addresses and are released together with dst; src
+ * is empty afterwards. Lets buffers filled on different threads be merged
+ * without copying their strings.
+ */
+void arena_adopt(struct arena *dst, struct arena *src);
+
+/**
+ * @brief The current position of the arena.
+ */
+struct arena_mark arena_save(const struct arena *a);
+
+/**
+ * @brief Releases every allocation made since mark was saved.
+ *
+ * Lets a caller undo a series of allocations that failed half way without
+ * setting up an arena of its own. Nothing may have been adopted into the
+ * arena or released from it in between.
+ */
+void arena_rollback(struct arena *a, struct arena_mark mark);
+
+/**
+ * @brief Releases every allocation made from the arena.
+ *
+ * The arena is empty afterwards and can be reused.
+ */
+void arena_release(struct arena *a);
+
+
+#endif
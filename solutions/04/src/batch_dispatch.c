@@ -0,0 +1,249 @@
+#include "batch_dispatch.h"
+#include "intern.h"
+#include "payload.h"
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define GROUP_CACHE_SIZE 16
+
+/* slots of this many names per payload are remembered between lookup and
+ * update, further names are looked up twice */
+#define CACHED_NAMES 8
+
+
+/* last scheduled position of a name within the batch, level is -1 for a name
+ * seen for the first time */
+struct name_slot {
+	const char *name;
+	int level;
+	int group;
+};
+
+struct name_table {
+	struct name_slot *slots;
+	size_t mask;
+};
+
+
+/* finds the slot of name, claiming a new one if the name is not there yet */
+static struct name_slot *find_name(struct name_table *table, const char *name)
+{
+	// names are interned, the ID is a perfect key and the pointer is
+	// compared instead of the bytes
+	uint32_t h = interned_id(name) * 2654435761u;
+
+	for (size_t i = h & table->mask;; i = (i + 1) & table->mask) {
+		struct name_slot *slot = &table->slots[i];
+
+		if (slot->name == NULL)
+			*slot = (struct name_slot) {
+				.name = name,
+				.level = -1,
+			};
+
+		if (slot->name == name)
+			return slot;
+	}
+}
+
+static struct name_table new_name_table(const struct payload *payloads, int n)
+{
+	size_t name_count = 0;
+
+	for (int i = 0; i < n; i++) {
+		const struct payload *p = &payloads[i];
+
+		if (p->vtable->name)
+			for (int k = 0; p->vtable->name(p, k); k++)
+				name_count++;
+	}
+
+	// keep the load factor at most 1/2
+	size_t cap = 2;
+	while (cap < name_count * 2)
+		cap *= 2;
+
+	struct name_table table = {
+		.slots = calloc(cap, sizeof(struct name_slot)),
+		.mask = cap - 1,
+	};
+	assert(table.slots);
+
+	return table;
+}
+
+/*
+ * Assigns each payload a level. Levels run one after another, groups inside a
+ * level in the order of their index, and payloads inside a group in arrival
+ * order. A payload is pushed to a later level only if an earlier payload
+ * sharing one of its names would otherwise run after it, so payloads sharing
+ * a name stay in arrival order. Payloads without names act as barriers.
+ *
+ * Returns the number of levels.
+ */
+static int assign_levels(const struct payload *payloads, int n,
+			 const int *group, int *level)
+{
+	struct name_table table = new_name_table(payloads, n);
+	int floor = 0, max_level = 0;
+
+	for (int i = 0; i < n; i++) {
+		const struct payload *p = &payloads[i];
+
+		if (p->vtable->name == NULL) {
+			level[i] = i > 0 ? max_level + 1 : 0;
+			max_level = level[i];
+			floor = level[i] + 1;
+
+			continue;
+		}
+
+		level[i] = floor;
+
+		struct name_slot *found[CACHED_NAMES];
+		const char *name;
+
+		for (int k = 0; (name = p->vtable->name(p, k)); k++) {
+			struct name_slot *slot = find_name(&table, name);
+
+			if (k < CACHED_NAMES)
+				found[k] = slot;
+
+			if (slot->level < 0)
+				continue;
+
+			int after = slot->group <= group[i] ?
+				slot->level : slot->level + 1;
+
+			if (after > level[i])
+				level[i] = after;
+		}
+
+		for (int k = 0; (name = p->vtable->name(p, k)); k++) {
+			struct name_slot *slot = k < CACHED_NAMES ?
+				found[k] : find_name(&table, name);
+
+			slot->level = level[i];
+			slot->group = group[i];
+		}
+
+		if (level[i] > max_level)
+			max_level = level[i];
+	}
+
+	free(table.slots);
+
+	return max_level + 1;
+}
+
+/* numbers groups in order of first appearance, returns the group count */
+static int assign_groups(const struct payload *payloads, int n, int *group,
+			 const struct payload_vtable **vtables)
+{
+	// There are only a few distinct vtables. A small direct-mapped cache
+	// in front of the linear search keeps the lookup free of mispredicted
+	// branches.
+	struct {
+		const struct payload_vtable *vtable;
+		int group;
+	} cache[GROUP_CACHE_SIZE] = {};
+
+	int group_count = 0;
+
+	for (int i = 0; i < n; i++) {
+		const struct payload_vtable *vtable = payloads[i].vtable;
+		size_t slot = (uintptr_t) vtable /
+			alignof(struct payload_vtable) % GROUP_CACHE_SIZE;
+
+		if (cache[slot].vtable == vtable) {
+			group[i] = cache[slot].group;
+			continue;
+		}
+
+		int g;
+		for (g = 0; g < group_count; g++)
+			if (vtables[g] == vtable)
+				break;
+
+		if (g == group_count)
+			vtables[group_count++] = vtable;
+
+		cache[slot].vtable = vtable;
+		cache[slot].group = group[i] = g;
+	}
+
+	return group_count;
+}
+
+int process_batch(struct payload_buffer *buf, int window,
+		  enum batch_order order)
+{
+	// pending payloads are taken as one slice, which a ring may split
+	assert(buf->high_water == 0);
+
+	int n = buf->len - buf->process_base;
+	if (n > window)
+		n = window;
+	if (n <= 0)
+		return 0;
+
+	struct payload *payloads = &buf->payloads[buf->process_base];
+
+	const struct payload_vtable **vtables = malloc(n * sizeof(*vtables));
+	struct payload **sorted = malloc(n * sizeof(*sorted));
+	int *group = malloc(n * sizeof(int));
+	int *key = malloc(n * sizeof(int));
+	assert(vtables && sorted && group && key);
+
+	int group_count = assign_groups(payloads, n, group, vtables);
+
+	// the sort key is (level, group); without ordering by name everything
+	// is on level 0
+	int level_count = 1;
+
+	if (order == BATCH_NAME_ORDER) {
+		level_count = assign_levels(payloads, n, group, key);
+
+		for (int i = 0; i < n; i++)
+			key[i] = key[i] * group_count + group[i];
+	} else {
+		key = memcpy(key, group, n * sizeof(int));
+	}
+
+	// stable counting sort, a run of the same vtable ends at each offset
+	int bucket_count = level_count * group_count;
+	int *offsets = calloc(bucket_count + 1, sizeof(int));
+	assert(offsets);
+
+	for (int i = 0; i < n; i++)
+		offsets[key[i] + 1]++;
+	for (int b = 0; b < bucket_count; b++)
+		offsets[b + 1] += offsets[b];
+	for (int i = 0; i < n; i++)
+		sorted[offsets[key[i]]++] = &payloads[i];
+
+	// offsets now hold the end of every bucket, and each bucket calls the
+	// same function over and over
+	for (int b = 0, i = 0; b < bucket_count; b++) {
+		void (*process)(const struct payload *self) =
+			vtables[b % group_count]->process;
+
+		for (; i < offsets[b]; i++)
+			process(sorted[i]);
+	}
+
+	free(offsets);
+	free(key);
+	free(group);
+	free(sorted);
+	free(vtables);
+
+	buf->process_base += n;
+
+	return n;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file batch_dispatch.h
+ * @brief Processing pending payloads grouped by their vtable.
+ *
+ * process_next calls a different process method almost every time, so the
+ * indirect call is hard to predict. process_batch takes a window of pending
+ * payloads, partitions it by vtable and runs each group in a tight loop with
+ * a single call target.
+ */
+
+
+#ifndef BATCH_DISPATCH_H
+#define BATCH_DISPATCH_H
+
+
+#include "dynamic_dispatch.h"
+
+
+/**
+ * @brief Which payloads must keep their relative order inside a batch.
+ */
+enum batch_order {
+	/** Only payloads of the same type keep their order */
+	BATCH_ANY_ORDER,
+	/** Payloads sharing a user or channel name keep their order too, and
+	 * payloads concerning every user (such as logout) are not reordered */
+	BATCH_NAME_ORDER,
+};
+
+
+/**
+ * @brief Processes up to window pending payloads, grouped by vtable.
+ *
+ * @param buf Pointer to the payload buffer
+ * @param window Maximum number of payloads to process
+ * @param order Ordering guarantee of the batch
+ * @return Number of payloads processed, 0 if none is pending
+ */
+int process_batch(struct payload_buffer *buf, int window,
+		  enum batch_order order);
+
+
+#endif
@@ -0,0 +1,174 @@
+#include "channel_registry.h"
+#include "intern.h"
+#include "roaring.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+
+struct channel {
+	const char *name;  /**< Interned, NULL for a free slot */
+	struct roaring members;
+};
+
+
+static pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+static struct channel *slots;
+static size_t mask;
+static size_t count;
+
+
+/* slot of channel, claiming a free one when create is set, NULL if absent;
+ * called with the lock held, exclusively when creating */
+static struct channel *find_channel(const char *name, bool create)
+{
+	if (slots == NULL) {
+		if (!create)
+			return NULL;
+
+		slots = calloc(16, sizeof(struct channel));
+		assert(slots);
+		mask = 15;
+	}
+
+	// names are interned, the ID is a perfect key and the pointer is
+	// compared instead of the bytes
+	size_t i = interned_id(name) * 2654435761u & mask;
+
+	for (; slots[i].name != NULL; i = (i + 1) & mask)
+		if (slots[i].name == name)
+			return &slots[i];
+
+	if (!create)
+		return NULL;
+
+	slots[i].name = name;
+	count++;
+	return &slots[i];
+}
+
+/* doubles the table, called with the lock held exclusively */
+static void grow()
+{
+	size_t cap = (mask + 1) * 2;
+	struct channel *old = slots;
+	size_t old_cap = mask + 1;
+
+	slots = calloc(cap, sizeof(struct channel));
+	assert(slots);
+	mask = cap - 1;
+
+	for (size_t i = 0; i < old_cap; i++) {
+		if (old[i].name == NULL)
+			continue;
+
+		size_t j = interned_id(old[i].name) * 2654435761u & mask;
+		while (slots[j].name != NULL)
+			j = (j + 1) & mask;
+
+		slots[j] = old[i];
+	}
+
+	free(old);
+}
+
+void join_channel(const char *channel, const char *user)
+{
+	pthread_rwlock_wrlock(&lock);
+
+	roaring_add(&find_channel(channel, true)->members, interned_id(user));
+
+	// keep the load factor at most 1/2
+	if (count * 2 > mask + 1)
+		grow();
+
+	pthread_rwlock_unlock(&lock);
+}
+
+void leave_channels(const char *user)
+{
+	uint32_t id = interned_id(user);
+
+	pthread_rwlock_wrlock(&lock);
+
+	for (size_t i = 0; slots && i <= mask; i++)
+		if (slots[i].name != NULL)
+			roaring_remove(&slots[i].members, id);
+
+	pthread_rwlock_unlock(&lock);
+}
+
+void for_each_member(const char *channel,
+		     void (*visit)(const char *user, void *ctx), void *ctx)
+{
+	pthread_rwlock_rdlock(&lock);
+
+	struct channel *found = find_channel(channel, false);
+
+	if (found) {
+		struct roaring_cursor cursor = { 0 };
+		uint32_t id;
+
+		while (roaring_next(&found->members, &cursor, &id))
+			visit(interned_name(id), ctx);
+	}
+
+	pthread_rwlock_unlock(&lock);
+}
+
+uint64_t channel_size(const char *channel)
+{
+	pthread_rwlock_rdlock(&lock);
+
+	struct channel *found = find_channel(channel, false);
+	uint64_t size = found ? roaring_cardinality(&found->members) : 0;
+
+	pthread_rwlock_unlock(&lock);
+
+	return size;
+}
+
+uint64_t shared_members(const char *a, const char *b)
+{
+	pthread_rwlock_rdlock(&lock);
+
+	struct channel *found_a = find_channel(a, false);
+	struct channel *found_b = find_channel(b, false);
+	uint64_t shared = found_a && found_b ?
+		roaring_and_cardinality(&found_a->members,
+					&found_b->members) : 0;
+
+	pthread_rwlock_unlock(&lock);
+
+	return shared;
+}
+
+size_t channel_bytes(const char *channel)
+{
+	pthread_rwlock_rdlock(&lock);
+
+	struct channel *found = find_channel(channel, false);
+	size_t bytes = found ? roaring_bytes(&found->members) : 0;
+
+	pthread_rwlock_unlock(&lock);
+
+	return bytes;
+}
+
+void clear_channel_registry(void)
+{
+	pthread_rwlock_wrlock(&lock);
+
+	for (size_t i = 0; slots && i <= mask; i++)
+		if (slots[i].name != NULL)
+			roaring_free(&slots[i].members);
+
+	free(slots);
+	slots = NULL;
+	mask = 0;
+	count = 0;
+
+	pthread_rwlock_unlock(&lock);
+}
@@ -0,0 +1,66 @@
+/**
+ * @file channel_registry.h
+ * @brief Members of every channel, shared by all threads.
+ *
+ * Channels and users are identified by their interned names. Each channel
+ * keeps its members as a compressed bitmap of interned user IDs, so a
+ * channel with a hundred thousand members takes a few KiB and is walked or
+ * intersected word by word. Reading channels may happen concurrently,
+ * changing them takes the registry lock exclusively.
+ */
+
+
+#ifndef CHANNEL_REGISTRY_H
+#define CHANNEL_REGISTRY_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Adds user to the members of channel, creating the channel.
+ *
+ * @param channel Interned channel name
+ * @param user Interned user name
+ */
+void join_channel(const char *channel, const char *user);
+
+/**
+ * @brief Removes user from every channel it is a member of.
+ *
+ * Visits every channel, which is fine as long as there are far fewer
+ * channels than payloads.
+ */
+void leave_channels(const char *user);
+
+/**
+ * @brief Calls visit with every member of channel in ID order.
+ *
+ * The registry cannot change meanwhile, visit must not call back into it.
+ */
+void for_each_member(const char *channel,
+		     void (*visit)(const char *user, void *ctx), void *ctx);
+
+/**
+ * @brief Number of members of channel, 0 if nobody ever joined it.
+ */
+uint64_t channel_size(const char *channel);
+
+/**
+ * @brief Number of users who are members of both channels.
+ */
+uint64_t shared_members(const char *a, const char *b);
+
+/**
+ * @brief Bytes of heap memory the members of channel occupy.
+ */
+size_t channel_bytes(const char *channel);
+
+/**
+ * @brief Forgets every channel.
+ */
+void clear_channel_registry(void);
+
+
+#endif
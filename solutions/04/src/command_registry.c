@@ -0,0 +1,100 @@
+#include "command_registry.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* seeds tried per table size before the table is doubled */
+#define SEEDS_PER_SIZE 1024
+
+
+/* FNV-1a, with the seed folded into the offset basis */
+static inline uint32_t hash(const char *name, size_t len, uint32_t seed)
+{
+	uint32_t h = 2166136261u ^ seed;
+
+	for (size_t i = 0; i < len; i++) {
+		h ^= (unsigned char) name[i];
+		h *= 16777619u;
+	}
+
+	// fold high bits into the low ones the mask keeps
+	return h ^ (h >> 16);
+}
+
+/* places every command, false if two of them share a slot */
+static bool try_seed(struct command_registry *registry,
+		     const struct command *commands, size_t count)
+{
+	memset(registry->slots, 0,
+	       (registry->mask + 1) * sizeof(struct command_slot));
+
+	for (size_t i = 0; i < count; i++) {
+		size_t len = strlen(commands[i].name);
+		struct command_slot *slot = &registry->slots[
+			hash(commands[i].name, len, registry->seed) &
+			registry->mask];
+
+		if (slot->command != NULL) {
+			// no seed separates two commands of the same name
+			assert(strcmp(slot->command->name,
+				      commands[i].name) != 0);
+
+			return false;
+		}
+
+		*slot = (struct command_slot) {
+			.command = &commands[i],
+			.len = len,
+		};
+	}
+
+	return true;
+}
+
+void build_command_registry(struct command_registry *registry,
+			    const struct command *commands, size_t count)
+{
+	// start with a load factor of at most 1/2
+	size_t size = 1;
+	while (size < count * 2)
+		size *= 2;
+
+	registry->slots = NULL;
+
+	for (;; size *= 2) {
+		registry->mask = size - 1;
+		registry->slots = realloc(registry->slots,
+					  size * sizeof(struct command_slot));
+		assert(registry->slots);
+
+		for (registry->seed = 0; registry->seed < SEEDS_PER_SIZE;
+		     registry->seed++)
+			if (try_seed(registry, commands, count))
+				return;
+	}
+}
+
+const struct command *find_command(const struct command_registry *registry,
+				   const char *name, size_t len)
+{
+	const struct command_slot *slot =
+		&registry->slots[hash(name, len, registry->seed) &
+				 registry->mask];
+
+	// the slot holds the only command this name can be; name may hold a
+	// NUL, so the lengths are compared before any byte
+	if (slot->command == NULL || slot->len != len ||
+	    memcmp(slot->command->name, name, len) != 0)
+		return NULL;
+
+	return slot->command;
+}
+
+void free_command_registry(struct command_registry *registry)
+{
+	free(registry->slots);
+	registry->slots = NULL;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file command_registry.h
+ * @brief Constant time lookup of commands by name.
+ *
+ * Every command registers its name, its vtable and a constructor for its
+ * arguments. The registry places the commands into a table through a hash
+ * function whose seed is searched until no two names collide, so a lookup is
+ * one hash, one slot and one name comparison regardless of how many commands
+ * exist.
+ */
+
+
+#ifndef COMMAND_REGISTRY_H
+#define COMMAND_REGISTRY_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+struct arena;
+struct line_cursor;
+union payload_data;
+
+
+/**
+ * @brief A command that can be parsed from a "/name arguments..." line.
+ */
+struct command {
+	const char *name;                     /**< Name without the slash */
+	const struct payload_vtable *vtable;  /**< Behavior of the payload */
+
+	/**
+	 * @brief Fills payload data from the arguments, may be NULL if the
+	 *        command takes no arguments.
+	 */
+	void (*construct)(union payload_data *data, struct line_cursor *args,
+			  struct arena *strings);
+};
+
+/**
+ * @brief A command placed in the registry, and the length of its name.
+ */
+struct command_slot {
+	const struct command *command;  /**< NULL if empty */
+	size_t len;
+};
+
+/**
+ * @brief Perfect hash table of commands.
+ */
+struct command_registry {
+	struct command_slot *slots;  /**< Power of 2 sized */
+	uint32_t mask;               /**< Number of slots minus one */
+	uint32_t seed;               /**< Collision-free hash seed */
+};
+
+
+/**
+ * @brief Builds a registry over commands, which must outlive it.
+ *
+ * @param registry Output for the registry
+ * @param commands Commands with distinct names
+ * @param count Number of commands
+ */
+void build_command_registry(struct command_registry *registry,
+			    const struct command *commands, size_t count);
+
+/**
+ * @brief Finds the command called name.
+ *
+ * @param name Command name, does not need to be NUL-terminated
+ * @param len Length of the name
+ * @return The registered command, NULL if there is none with that name
+ */
+const struct command *find_command(const struct command_registry *registry,
+				   const char *name, size_t len);
+
+/**
+ * @brief Frees the table of the registry.
+ */
+void free_command_registry(struct command_registry *registry);
+
+
+#endif
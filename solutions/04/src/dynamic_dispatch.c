@@ -1,9 +1,12 @@
 #include "dynamic_dispatch.h"
 #include "payload.h"
+#include "payload_log.h"
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
 
 struct payload_buffer *new_buffer()
@@ -13,20 +16,46 @@ struct payload_buffer *new_buffer()
 
 	buf->process_base = buf->len = 0;
 	buf->cap = 1;
+	buf->strings = (struct arena) { .chunks = NULL };
+	buf->log = NULL;
+	buf->high_water = buf->head = 0;
+	buf->dropped = buf->generation_start = 0;
+	buf->generations = NULL;
+	buf->generation_count = buf->generation_cap = 0;
 	buf->payloads = malloc(sizeof(struct payload));
 	assert(buf->payloads);
 
 	return buf;
 }
 
-void push_payload(struct payload_buffer *buf, const char *raw)
+/* slot of payload i, which wraps around the end of a streaming buffer */
+static int slot(const struct payload_buffer *buf, int i)
+{
+	int at = buf->head + i;
+
+	return at < buf->cap ? at : at - buf->cap;
+}
+
+bool push_payload(struct payload_buffer *buf, const struct payload_line *line)
 {
 	struct payload parsed;
 
-	bool is_parsing_successful = parse_payload(&parsed, raw);
+	// before parsing, which puts the strings into the current generation
+	if (buf->high_water > 0) {
+		if (buffer_full(buf))
+			return false;
+
+		compact_buffer(buf);
+	}
+
+	bool is_parsing_successful = parse_payload(&parsed, line,
+						   &buf->strings);
 
 	if (is_parsing_successful) {
 		if (buf->cap == buf->len) {
+			// a streaming ring is allocated whole
+			assert(buf->high_water == 0);
+
 			buf->cap *= 2;
 			buf->payloads = realloc(buf->payloads,
 			   buf->cap * sizeof(struct payload));
@@ -34,27 +63,206 @@ void push_payload(struct payload_buffer *buf, const char *raw)
 			assert(buf->payloads);
 		}
 
-		buf->payloads[buf->len++] = parsed;
+		buf->payloads[slot(buf, buf->len++)] = parsed;
+
+		if (buf->log)
+			log_payload(buf->log, &parsed);
+	}
+
+	return is_parsing_successful;
+}
+
+void reserve_payloads(struct payload_buffer *buf, int count)
+{
+	assert(count >= 0);
+
+	int needed = buf->len + count;
+
+	if (buf->high_water > 0 && needed > buf->high_water)
+		needed = buf->high_water;
+
+	if (needed <= buf->cap)
+		return;
+
+	buf->cap = needed;
+	buf->payloads = realloc(buf->payloads,
+				buf->cap * sizeof(struct payload));
+	assert(buf->payloads);
+}
+
+/* every thread reuses one index for its bulk pushes, freed when it exits */
+static pthread_key_t bulk_index_key;
+static pthread_once_t bulk_index_once = PTHREAD_ONCE_INIT;
+
+static void free_bulk_index(void *idx)
+{
+	free_structural_index(idx);
+	free(idx);
+}
+
+static void create_bulk_index_key()
+{
+	[[maybe_unused]] int created =
+		pthread_key_create(&bulk_index_key, free_bulk_index);
+	assert(created == 0);
+}
+
+static struct structural_index *bulk_index()
+{
+	pthread_once(&bulk_index_once, create_bulk_index_key);
+
+	struct structural_index *idx = pthread_getspecific(bulk_index_key);
+
+	if (idx == NULL) {
+		idx = calloc(1, sizeof(struct structural_index));
+		assert(idx);
+
+		[[maybe_unused]] int set = pthread_setspecific(bulk_index_key,
+							       idx);
+		assert(set == 0);
+	}
+
+	return idx;
+}
+
+int push_payloads_bulk(struct payload_buffer *buf, const char *block,
+		       size_t len)
+{
+	long before = buf->dropped + buf->len;
+
+	struct structural_index *idx = bulk_index();
+
+	build_structural_index(idx, block, len);
+	int count = idx->line_count;
+
+	// at least doubling, so unreserved blocks pushed one after the other
+	// still copy the array only a logarithmic number of times
+	if (buf->len + count > buf->cap)
+		reserve_payloads(buf, count > buf->len ? count : buf->len);
+
+	for (size_t i = 0; i < idx->line_count; i++) {
+		struct payload_line line;
+		indexed_line(idx, block, i, &line);
+
+		if (line.start != line.end)
+			push_payload(buf, &line);
 	}
+
+	return buf->dropped + buf->len - before;
 }
 
 void process_next(struct payload_buffer *buf)
 {
 	assert(buf->process_base < buf->len);
 
-	struct payload *p = &buf->payloads[buf->process_base];
+	struct payload *p = &buf->payloads[slot(buf, buf->process_base)];
 	p->vtable->process(p);
 
 	buf->process_base += 1;
 }
 
-void destroy(struct payload_buffer *buf)
+struct payload *buffer_payload(struct payload_buffer *buf, int i)
+{
+	assert(i >= 0 && i < buf->len);
+
+	return &buf->payloads[slot(buf, i)];
+}
+
+void stream_buffer(struct payload_buffer *buf, int high_water)
+{
+	assert(high_water > 0);
+	assert(buf->high_water == 0);
+
+	int pending = buf->len - buf->process_base;
+	assert(pending <= high_water);
+
+	// the only move of payloads, the ring only moves its head afterwards
+	memmove(buf->payloads, buf->payloads + buf->process_base,
+		pending * sizeof(struct payload));
+
+	buf->dropped += buf->process_base;
+	buf->len = pending;
+	buf->process_base = 0;
+
+	buf->high_water = buf->cap = high_water;
+	buf->payloads = realloc(buf->payloads,
+				buf->cap * sizeof(struct payload));
+	assert(buf->payloads);
+}
+
+bool buffer_full(const struct payload_buffer *buf)
+{
+	return buf->high_water > 0 &&
+		buf->len - buf->process_base >= buf->high_water;
+}
+
+/* releases the generations whose payloads have all been processed */
+static void release_generations(struct payload_buffer *buf)
+{
+	long processed = buf->dropped + buf->process_base;
+	int released = 0;
+
+	while (released < buf->generation_count &&
+	       buf->generations[released].end <= processed)
+		arena_release(&buf->generations[released++].strings);
+
+	if (released == 0)
+		return;
+
+	buf->generation_count -= released;
+	memmove(buf->generations, buf->generations + released,
+		buf->generation_count * sizeof(struct string_generation));
+}
+
+void compact_buffer(struct payload_buffer *buf)
 {
-	for (int i = 0; i < buf->len; i++) {
-		struct payload *p = &buf->payloads[i];
-		p->vtable->destroy(p);
+	assert(buf->high_water > 0);
+
+	release_generations(buf);
+
+	long pushed = buf->dropped + buf->len;
+
+	// strings of unprocessed payloads must stay, the current arena is set
+	// aside once it holds a whole window, until they are processed too
+	if (buf->process_base == buf->len) {
+		arena_release(&buf->strings);
+		buf->generation_start = pushed;
+	} else if (pushed - buf->generation_start >= buf->high_water &&
+		   buf->strings.chunks != NULL) {
+		if (buf->generation_count == buf->generation_cap) {
+			buf->generation_cap = buf->generation_cap ?
+				buf->generation_cap * 2 : 4;
+			buf->generations = realloc(buf->generations,
+				buf->generation_cap *
+				sizeof(struct string_generation));
+			assert(buf->generations);
+		}
+
+		buf->generations[buf->generation_count++] =
+			(struct string_generation) {
+				.strings = buf->strings,
+				.end = pushed,
+			};
+		buf->strings = (struct arena) { .chunks = NULL };
+		buf->generation_start = pushed;
 	}
 
+	buf->head = slot(buf, buf->process_base);
+	buf->dropped += buf->process_base;
+	buf->len -= buf->process_base;
+	buf->process_base = 0;
+}
+
+void destroy(struct payload_buffer *buf)
+{
+	// every string and receiver array lives in the arena, payloads are
+	// released all at once instead of one by one
+	arena_release(&buf->strings);
+
+	for (int i = 0; i < buf->generation_count; i++)
+		arena_release(&buf->generations[i].strings);
+
+	free(buf->generations);
 	free(buf->payloads);
 	free(buf);
 }
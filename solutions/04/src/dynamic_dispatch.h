@@ -8,20 +8,115 @@
 #define DYNAMIC_DISPATCH_H
 
 
+#include "arena.h"
+#include "structural_index.h"
+
+
+#include <stdbool.h>
+
+
+struct payload_log;
+
+/**
+ * @brief Strings of a run of pushed payloads, released once the last of
+ * those payloads has been processed.
+ */
+struct string_generation {
+	struct arena strings;
+	long end;  /**< Number of payloads pushed up to the last of the run */
+};
+
 struct payload_buffer {
 	struct payload *payloads;
 	int len;
 	int cap;
 	int process_base;
+	struct arena strings;
+	struct payload_log *log;  /**< Pushed payloads are appended, if set */
+
+	int high_water;           /**< Limit of unprocessed payloads if > 0 */
+	int head;                 /**< Slot of payload 0 */
+	long dropped;             /**< Payloads removed by compaction so far */
+	long generation_start;    /**< Payloads pushed before those in strings */
+	struct string_generation *generations;  /**< Oldest first */
+	int generation_count;
+	int generation_cap;
 };
 
 
 struct payload_buffer *new_buffer();
 
-void push_payload(struct payload_buffer *buf, const char *raw);
+/**
+ * @brief Parses a line and appends its payload.
+ *
+ * @return False if the line is invalid, or if a streaming buffer is full;
+ *         nothing is parsed then
+ */
+bool push_payload(struct payload_buffer *buf, const struct payload_line *line);
+
+/**
+ * @brief Makes room for count more payloads with a single allocation.
+ *
+ * push_payload grows the array by doubling; reserving up front from a line
+ * count spares the copies and the peak of old and new array side by side.
+ * Streaming buffers reserve no more than their high-water mark.
+ */
+void reserve_payloads(struct payload_buffer *buf, int count);
+
+/**
+ * @brief Pushes every non-empty line of a block of newline-separated lines.
+ *
+ * The block is indexed once and the array reserved for all of its lines
+ * before any of them is parsed. Lines that find a streaming buffer full are
+ * refused.
+ *
+ * @param block Input bytes, at most STRUCTURAL_INDEX_MAX_BLOCK long
+ * @param len Length of the block
+ * @return Number of payloads pushed
+ */
+int push_payloads_bulk(struct payload_buffer *buf, const char *block,
+		       size_t len);
 
 void process_next(struct payload_buffer *buf);
 
+/**
+ * @brief Payload i, between process_base and len.
+ *
+ * The same as &buf->payloads[i] unless the buffer is streaming, where the
+ * payloads wrap around the end of the array.
+ */
+struct payload *buffer_payload(struct payload_buffer *buf, int i);
+
+/**
+ * @brief Switches the buffer to streaming mode.
+ *
+ * Instead of growing for as long as payloads are pushed, the buffer then
+ * becomes a ring of high_water slots: processed payloads are dropped by
+ * moving the head past them, so a push costs the same however full the ring
+ * is. Strings are released a generation of high_water pushes at a time,
+ * once every payload of the generation has been processed. Memory stays
+ * proportional to the window between pushing and processing, not to the
+ * total number of payloads.
+ *
+ * Producers must process payloads while buffer_full() is true, pushes are
+ * refused until then. Indices of unprocessed payloads change on a push, and
+ * slots are reached through buffer_payload().
+ */
+void stream_buffer(struct payload_buffer *buf, int high_water);
+
+/**
+ * @brief Whether a streaming buffer has no room for another payload.
+ */
+bool buffer_full(const struct payload_buffer *buf);
+
+/**
+ * @brief Drops the processed payloads of a streaming buffer and releases the
+ * strings no unprocessed payload uses.
+ *
+ * Done by push_payload on its own in streaming mode.
+ */
+void compact_buffer(struct payload_buffer *buf);
+
 void destroy(struct payload_buffer *buf);
 
 
@@ -0,0 +1,178 @@
+#include "intern.h"
+#include "arena.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define SHARD_BITS 6
+#define SHARDS (1 << SHARD_BITS)
+
+/* the ID directory is split into blocks allocated on first use */
+#define BLOCK_BITS 12
+#define BLOCK_SIZE (1 << BLOCK_BITS)
+#define BLOCKS (1 << (32 - BLOCK_BITS))
+
+
+/* header in front of every interned string */
+struct interned {
+	uint32_t id;
+	uint32_t hash;
+	uint32_t len;
+	char name[];
+};
+
+struct shard {
+	pthread_mutex_t lock;
+	struct interned **slots;
+	size_t mask;
+	size_t count;
+	struct arena names;
+};
+
+
+static struct shard shards[SHARDS];
+static pthread_once_t shards_once = PTHREAD_ONCE_INIT;
+
+static atomic_uint next_id;
+static _Atomic(struct interned **) blocks[BLOCKS];
+
+
+static void init_shards()
+{
+	for (int i = 0; i < SHARDS; i++) {
+		shards[i] = (struct shard) {
+			.slots = calloc(16, sizeof(struct interned *)),
+			.mask = 15,
+			.names = { .chunks = NULL },
+		};
+		assert(shards[i].slots);
+
+		pthread_mutex_init(&shards[i].lock, NULL);
+	}
+}
+
+static uint32_t hash(const char *str, size_t len)
+{
+	uint32_t h = 2166136261u;
+
+	for (size_t i = 0; i < len; i++) {
+		h ^= (unsigned char) str[i];
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+/* doubles the table of a shard, called with its lock held */
+static void grow(struct shard *shard)
+{
+	size_t cap = (shard->mask + 1) * 2;
+	struct interned **slots = calloc(cap, sizeof(struct interned *));
+	assert(slots);
+
+	for (size_t i = 0; i <= shard->mask; i++) {
+		struct interned *entry = shard->slots[i];
+		if (entry == NULL)
+			continue;
+
+		size_t j = entry->hash & (cap - 1);
+		while (slots[j] != NULL)
+			j = (j + 1) & (cap - 1);
+
+		slots[j] = entry;
+	}
+
+	free(shard->slots);
+	shard->slots = slots;
+	shard->mask = cap - 1;
+}
+
+/* publishes entry under its ID */
+static void publish(struct interned *entry)
+{
+	uint32_t block = entry->id >> BLOCK_BITS;
+	struct interned **directory = atomic_load_explicit(
+		&blocks[block], memory_order_acquire);
+
+	if (directory == NULL) {
+		struct interned **fresh = calloc(BLOCK_SIZE,
+						 sizeof(struct interned *));
+		assert(fresh);
+
+		// another shard may have allocated the block meanwhile
+		if (atomic_compare_exchange_strong(&blocks[block], &directory,
+						   fresh))
+			directory = fresh;
+		else
+			free(fresh);
+	}
+
+	directory[entry->id & (BLOCK_SIZE - 1)] = entry;
+}
+
+const char *intern(const char *str, size_t len)
+{
+	pthread_once(&shards_once, init_shards);
+
+	uint32_t h = hash(str, len);
+	struct shard *shard = &shards[h >> (32 - SHARD_BITS)];
+
+	pthread_mutex_lock(&shard->lock);
+
+	size_t i = h & shard->mask;
+
+	for (struct interned *entry; (entry = shard->slots[i]) != NULL;
+	     i = (i + 1) & shard->mask)
+		if (entry->hash == h && entry->len == len &&
+		    memcmp(entry->name, str, len) == 0) {
+			pthread_mutex_unlock(&shard->lock);
+			return entry->name;
+		}
+
+	struct interned *entry = arena_alloc(&shard->names,
+					     sizeof(struct interned) + len + 1,
+					     alignof(struct interned));
+	entry->id = atomic_fetch_add(&next_id, 1);
+	entry->hash = h;
+	entry->len = len;
+	memcpy(entry->name, str, len);
+	entry->name[len] = '\0';
+
+	shard->slots[i] = entry;
+	publish(entry);
+
+	// keep the load factor at most 1/2
+	if (++shard->count * 2 > shard->mask + 1)
+		grow(shard);
+
+	pthread_mutex_unlock(&shard->lock);
+
+	return entry->name;
+}
+
+uint32_t interned_id(const char *name)
+{
+	const struct interned *entry = (const struct interned *)
+		(name - offsetof(struct interned, name));
+
+	return entry->id;
+}
+
+const char *interned_name(uint32_t id)
+{
+	struct interned **directory = atomic_load_explicit(
+		&blocks[id >> BLOCK_BITS], memory_order_acquire);
+	assert(directory && directory[id & (BLOCK_SIZE - 1)]);
+
+	return directory[id & (BLOCK_SIZE - 1)]->name;
+}
+
+uint32_t interned_count(void)
+{
+	return atomic_load(&next_id);
+}
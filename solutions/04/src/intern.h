@@ -0,0 +1,49 @@
+/**
+ * @file intern.h
+ * @brief Process-wide pool of interned user and channel names.
+ *
+ * The same few thousand names repeat across millions of payloads. Each
+ * distinct name is stored once and gets a stable pointer and a dense ID, so
+ * payloads keep a handle instead of a copy, and two interned names are equal
+ * exactly when their pointers are.
+ *
+ * The pool is shared by every thread and sharded by hash, each shard behind
+ * a lock of its own. Interned names are never freed.
+ */
+
+
+#ifndef INTERN_H
+#define INTERN_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Interns the len bytes at str.
+ *
+ * @return NUL-terminated copy of the name, the same pointer for every call
+ *         with equal bytes
+ */
+const char *intern(const char *str, size_t len);
+
+/**
+ * @brief ID of an interned name. IDs count up from 0 in interning order.
+ *
+ * @param name Pointer returned by intern
+ */
+uint32_t interned_id(const char *name);
+
+/**
+ * @brief Name with the given ID, which must have been handed out already.
+ */
+const char *interned_name(uint32_t id);
+
+/**
+ * @brief Number of distinct names interned so far.
+ */
+uint32_t interned_count(void);
+
+
+#endif
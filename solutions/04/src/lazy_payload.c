@@ -0,0 +1,139 @@
+#include "lazy_payload.h"
+#include "payload.h"
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* lines shorter than this are indexed by the scalar scan */
+#define SHORT_LINE 256
+
+
+static enum lazy_kind kind_of(char first)
+{
+	switch (first) {
+	case '/':
+		return LAZY_COMMAND;
+	case '@':
+		return LAZY_DIRECT_MESSAGE;
+	case '#':
+		return LAZY_GROUP_MESSAGE;
+	default:
+		return LAZY_GLOBAL_MESSAGE;
+	}
+}
+
+
+struct lazy_payload_buffer *lazy_new_buffer()
+{
+	struct lazy_payload_buffer *buf = malloc(
+		sizeof(struct lazy_payload_buffer));
+	assert(buf);
+
+	buf->process_base = buf->len = 0;
+	buf->cap = 1;
+	buf->strings = (struct arena) { .chunks = NULL };
+	buf->idx = (struct structural_index) { .marks = NULL };
+	buf->payloads = malloc(sizeof(struct lazy_payload));
+	assert(buf->payloads);
+
+	return buf;
+}
+
+int lazy_push_payloads(struct lazy_payload_buffer *buf, const char *block,
+		       size_t len)
+{
+	int before = buf->len;
+	const char *end = block + len;
+
+	for (const char *line = block; line < end;) {
+		const char *newline = memchr(line, '\n', end - line);
+		const char *stop = newline ? newline : end;
+
+		if (stop > line) {
+			if (buf->cap == buf->len) {
+				buf->cap *= 2;
+				buf->payloads = realloc(buf->payloads,
+					buf->cap * sizeof(struct lazy_payload));
+				assert(buf->payloads);
+			}
+
+			assert((size_t) (stop - line) <=
+			       STRUCTURAL_INDEX_MAX_BLOCK);
+
+			// the one byte looked at before processing
+			buf->payloads[buf->len++] = (struct lazy_payload) {
+				.line = line,
+				.len = stop - line,
+				.kind = kind_of(*line),
+			};
+		}
+
+		line = stop + 1;
+	}
+
+	return buf->len - before;
+}
+
+const struct payload *lazy_fields(struct lazy_payload_buffer *buf, int i)
+{
+	assert(i >= 0 && i < buf->len);
+
+	struct lazy_payload *p = &buf->payloads[i];
+
+	if (p->parsed)
+		return p->payload;
+
+	// the line is indexed on its own, as a block of one line; for short
+	// ones the vector setup and CPU dispatch cost more than a plain loop
+	struct payload_line line;
+
+	if (p->len < SHORT_LINE)
+		build_structural_index_scalar(&buf->idx, p->line, p->len);
+	else
+		build_structural_index(&buf->idx, p->line, p->len);
+	indexed_line(&buf->idx, p->line, 0, &line);
+
+	struct payload *parsed = arena_alloc(&buf->strings,
+					     sizeof(struct payload),
+					     alignof(struct payload));
+
+	p->payload = parse_payload(parsed, &line, &buf->strings) ?
+		parsed : NULL;
+	p->parsed = 1;
+
+	return p->payload;
+}
+
+void lazy_process_next(struct lazy_payload_buffer *buf)
+{
+	assert(buf->process_base < buf->len);
+
+	const struct payload *p = lazy_fields(buf, buf->process_base);
+
+	if (p)
+		p->vtable->process(p);
+
+	buf->process_base += 1;
+}
+
+void lazy_destroy(struct lazy_payload_buffer *buf)
+{
+	arena_release(&buf->strings);
+	free_structural_index(&buf->idx);
+
+	free(buf->payloads);
+	free(buf);
+}
+
+int lazy_count(const struct lazy_payload_buffer *buf, enum lazy_kind kind)
+{
+	int count = 0;
+
+	for (int i = 0; i < buf->len; i++)
+		count += buf->payloads[i].kind == kind;
+
+	return count;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file lazy_payload.h
+ * @brief Payloads that keep their raw line and are parsed on first access.
+ *
+ * Pushing a block only finds the end of each line and looks at its first
+ * byte, which tells commands from messages and, for messages, whether they
+ * go to a user, a channel or everyone. Tokenizing, copying strings and
+ * building receivers is left to the first access to the fields, done by
+ * processing. Workloads that count or drop most payloads by their kind never
+ * pay for parsing them.
+ *
+ * Lines point into the pushed blocks, which must outlive the buffer.
+ */
+
+
+#ifndef LAZY_PAYLOAD_H
+#define LAZY_PAYLOAD_H
+
+
+#include "arena.h"
+#include "structural_index.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+struct payload;
+
+/**
+ * @brief What the first byte of a line tells about its payload.
+ *
+ * A message is of the kind of its first receiver.
+ */
+enum lazy_kind {
+	LAZY_COMMAND,         /**< '/' */
+	LAZY_DIRECT_MESSAGE,  /**< '@' */
+	LAZY_GROUP_MESSAGE,   /**< '#' */
+	LAZY_GLOBAL_MESSAGE,  /**< Anything else */
+	LAZY_KIND_COUNT,
+};
+
+/**
+ * @brief A raw line, and its parsed payload once accessed.
+ */
+struct lazy_payload {
+	const char *line;
+	uint32_t len;
+	uint8_t kind;              /**< enum lazy_kind */
+	uint8_t parsed;            /**< Whether payload is set */
+	struct payload *payload;   /**< In the arena, NULL if invalid */
+};
+
+/**
+ * @brief Payload buffer with the same API as payload_buffer.
+ */
+struct lazy_payload_buffer {
+	struct lazy_payload *payloads;
+	int len;
+	int cap;
+	int process_base;
+
+	struct arena strings;
+	struct structural_index idx;  /**< Reused to parse single lines */
+};
+
+
+struct lazy_payload_buffer *lazy_new_buffer();
+
+/**
+ * @brief Pushes every non-empty line of a block without parsing it.
+ *
+ * @return Number of payloads pushed
+ */
+int lazy_push_payloads(struct lazy_payload_buffer *buf, const char *block,
+		       size_t len);
+
+/**
+ * @brief The parsed payload i, parsing it on first access.
+ *
+ * Invalid commands are reported when first accessed.
+ *
+ * @return NULL if the line is an invalid command
+ */
+const struct payload *lazy_fields(struct lazy_payload_buffer *buf, int i);
+
+/**
+ * @brief Parses the next payload if needed, and processes it.
+ */
+void lazy_process_next(struct lazy_payload_buffer *buf);
+
+void lazy_destroy(struct lazy_payload_buffer *buf);
+
+/**
+ * @brief Counts payloads of the given kind without parsing any.
+ */
+int lazy_count(const struct lazy_payload_buffer *buf, enum lazy_kind kind);
+
+
+#endif
@@ -1,41 +1,264 @@
 #include "dynamic_dispatch.h"
+#include "multi_ingest.h"
+#include "output_sink.h"
+#include "parallel_ingest.h"
+#include "payload.h"
+#include "payload_file.h"
+#include "payload_log.h"
+#include "pipeline.h"
+#include "structural_index.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 
-int main([[maybe_unused]] int argc, const char **args)
+static void process_all(struct payload_buffer *buf)
+{
+	printf("--- Processing payloads ---\n");
+	fflush(stdout);
+
+	// behaviors print a few lines per payload, they are collected in a
+	// large buffer and written out by a background thread
+	struct output_sink out;
+	sink_open(&out, STDOUT_FILENO, 0, true);
+	payload_output = &out;
+
+	for (int i = 0; i < buf->len; i++) {
+		sink_printf(&out, "Processing payload %d of %d\n", i + 1,
+			    buf->len);
+
+		process_next(buf);
+
+		sink_write(&out, "\n", 1);
+	}
+
+	payload_output = NULL;
+	sink_close(&out);
+}
+
+static void process_streamed(struct payload_buffer *buf,
+			     struct output_sink *out)
+{
+	sink_printf(out, "Processing payload %ld\n",
+		    buf->dropped + buf->process_base + 1);
+
+	process_next(buf);
+
+	sink_write(out, "\n", 1);
+}
+
+/* processes payloads while reading them, holding at most high_water of them
+ * at a time */
+static void stream(const struct payload_file *file, int high_water)
+{
+	struct payload_buffer *buf = new_buffer();
+	stream_buffer(buf, high_water);
+
+	printf("--- Reading and processing payloads ---\n");
+	fflush(stdout);
+
+	struct output_sink out;
+	sink_open(&out, STDOUT_FILENO, 0, true);
+	payload_output = &out;
+
+	struct structural_index idx = { .marks = NULL };
+	const char *block;
+	size_t block_len, cursor = 0;
+
+	while (next_block(file, &cursor, &block, &block_len)) {
+		build_structural_index(&idx, block, block_len);
+
+		for (size_t i = 0; i < idx.line_count; i++) {
+			struct payload_line line;
+			indexed_line(&idx, block, i, &line);
+
+			if (line.start == line.end)
+				continue;
+
+			// a full buffer refuses the push, the oldest payload
+			// makes room
+			if (buffer_full(buf))
+				process_streamed(buf, &out);
+
+			push_payload(buf, &line);
+		}
+	}
+
+	while (buf->process_base < buf->len)
+		process_streamed(buf, &out);
+
+	free_structural_index(&idx);
+
+	payload_output = NULL;
+	sink_close(&out);
+
+	printf("Processed %ld payloads\n", buf->dropped + buf->len);
+	destroy(buf);
+}
+
+/* processes the payloads a run with --log wrote, from a sequence number on */
+static int replay(int argc, const char **args)
 {
 	struct payload_buffer *buf = new_buffer();
+	uint64_t from = argc > 3 ? strtoull(args[3], NULL, 10) : 0;
 
-	FILE *file = fopen(args[1], "r");
+	printf("--- Replaying payloads ---\n");
 
-	char line[1024];
+	if (!replay_payload_log(buf, args[2], from)) {
+		fprintf(stderr, "Could not open %s.\n", args[2]);
+		destroy(buf);
+
+		return EXIT_FAILURE;
+	}
+
+	printf("Replayed %d payloads\n\n", buf->len);
+
+	process_all(buf);
+	destroy(buf);
+
+	return EXIT_SUCCESS;
+}
+
+/* reads several payload files at once, --depth sets how many */
+static int ingest_files(const char **paths, int count, const char **options,
+			int option_count)
+{
+	int depth = 0;
+	const char *log_dir = NULL;
+
+	for (int i = 0; i + 1 < option_count; i += 2) {
+		if (strcmp(options[i], "--depth") == 0)
+			depth = atoi(options[i + 1]);
+		else if (strcmp(options[i], "--log") == 0)
+			log_dir = options[i + 1];
+	}
+
+	struct payload_buffer *buf = new_buffer();
+	struct payload_log log;
+
+	if (log_dir) {
+		if (!open_payload_log(&log, log_dir, 0)) {
+			fprintf(stderr, "Could not open %s.\n", log_dir);
+			destroy(buf);
+
+			return EXIT_FAILURE;
+		}
+
+		buf->log = &log;
+	}
 
 	printf("--- Reading payloads ---\n");
-	while (fgets(line, 1024, file) != NULL) {
-		int line_len = strlen(line);
-		if (line_len < 2)
-			continue;
+	bool read = push_payload_files(buf, paths, count, depth);
+
+	if (log_dir) {
+		close_payload_log(&log);
+		buf->log = NULL;
+	}
 
-		line[line_len - 1] = '\0';
+	if (!read) {
+		fprintf(stderr, "Could not read every payload file.\n");
+		destroy(buf);
 
-		push_payload(buf, line);
+		return EXIT_FAILURE;
 	}
-	printf("Read %d payloads\n\n", buf->len);
 
-	fclose(file);
+	printf("Read %d payloads from %d files\n\n", buf->len, count);
 
-	printf("--- Processing payloads ---\n");
-	for (int i = 0; i < buf->len; i++) {
-		printf("Processing payload %d of %d\n", i + 1, buf->len);
+	process_all(buf);
+	destroy(buf);
 
-		process_next(buf);
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, const char **args)
+{
+	struct payload_file file;
+
+	if (argc > 2 && strcmp(args[1], "--replay") == 0)
+		return replay(argc, args);
+
+	// payload files come first, then the options
+	int files = 1;
+	while (1 + files < argc && strncmp(args[1 + files], "--", 2) != 0)
+		files++;
+
+	const char **options = args + 1 + files;
+	int option_count = argc - 1 - files;
+
+	// several files are read at once while they are parsed
+	if (files > 1)
+		return ingest_files(args + 1, files, options, option_count);
+
+	if (!map_payload_file(&file, args[1])) {
+		fprintf(stderr, "Could not open %s.\n", args[1]);
+
+		return EXIT_FAILURE;
+	}
+
+	// parse on a second thread and process blocks as soon as they are ready
+	if (option_count > 0 && strcmp(options[0], "--pipeline") == 0) {
+		printf("--- Reading and processing payloads ---\n");
+		long processed = process_pipelined(&file,
+						   PIPELINE_DEFAULT_DEPTH);
+		printf("\nProcessed %ld payloads\n", processed);
+
+		unmap_payload_file(&file);
+
+		return EXIT_SUCCESS;
+	}
+
+	// a thread count of 0 uses every CPU
+	int workers = 1;
+	int high_water = 0;
+	const char *log_dir = NULL;
+
+	for (int i = 0; i + 1 < option_count; i += 2) {
+		if (strcmp(options[i], "--threads") == 0)
+			workers = atoi(options[i + 1]);
+		else if (strcmp(options[i], "--log") == 0)
+			log_dir = options[i + 1];
+		else if (strcmp(options[i], "--stream") == 0)
+			high_water = atoi(options[i + 1]);
+	}
+
+	// memory bounded by the window instead of the input
+	if (high_water > 0) {
+		stream(&file, high_water);
+		unmap_payload_file(&file);
+
+		return EXIT_SUCCESS;
+	}
+
+	struct payload_buffer *buf = new_buffer();
+	struct payload_log log;
+
+	// every payload read is appended to the log for a later --replay
+	if (log_dir) {
+		if (!open_payload_log(&log, log_dir, 0)) {
+			fprintf(stderr, "Could not open %s.\n", log_dir);
+			unmap_payload_file(&file);
+			destroy(buf);
+
+			return EXIT_FAILURE;
+		}
+
+		buf->log = &log;
+	}
+
+	printf("--- Reading payloads ---\n");
+	push_payloads_parallel(buf, &file, workers);
+	printf("Read %d payloads\n\n", buf->len);
+
+	unmap_payload_file(&file);
 
-		printf("\n");
+	if (log_dir) {
+		close_payload_log(&log);
+		buf->log = NULL;
 	}
 
+	process_all(buf);
 	destroy(buf);
 
 	return EXIT_SUCCESS;
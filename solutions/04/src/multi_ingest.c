@@ -0,0 +1,436 @@
+// memrchr
+#define _GNU_SOURCE
+
+#include "multi_ingest.h"
+#include "payload.h"
+#include "payload_file.h"
+#include "payload_log.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+/* one file being read, and the buffer it is parsed into */
+struct file_ingest {
+	int fd;
+	uint64_t offset;      /**< Of the next read */
+	char *data;           /**< Carried over partial line, then the read */
+	size_t len;
+	size_t cap;
+	struct payload_buffer *parsed;
+};
+
+
+/* appends the buffers of the files to buf in order unless a file failed, and
+ * destroys them */
+static bool merge_files(struct payload_buffer *buf,
+			struct payload_buffer **parsed, int count, bool failed)
+{
+	if (!failed) {
+		int total = 0;
+		for (int i = 0; i < count; i++)
+			total += parsed[i]->len;
+
+		reserve_payloads(buf, total);
+
+		for (int i = 0; i < count; i++) {
+			struct payload *merged = &buf->payloads[buf->len];
+
+			memcpy(merged, parsed[i]->payloads,
+			       parsed[i]->len * sizeof(struct payload));
+			buf->len += parsed[i]->len;
+
+			for (int k = 0; buf->log && k < parsed[i]->len; k++)
+				log_payload(buf->log, &merged[k]);
+
+			arena_adopt(&buf->strings, &parsed[i]->strings);
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+		if (parsed[i])
+			destroy(parsed[i]);
+
+	return !failed;
+}
+
+bool push_payload_files(struct payload_buffer *buf, const char *const *paths,
+			int count, int depth)
+{
+	if (io_uring_available())
+		return push_payload_files_uring(buf, paths, count, depth);
+
+	return push_payload_files_threads(buf, paths, count, depth);
+}
+
+
+/* io_uring */
+
+/* the rings shared with the kernel, without liburing */
+struct uring {
+	int fd;
+
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	struct io_uring_sqe *sqes;
+	unsigned to_submit;
+
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+	unsigned entries;      /**< Of the submission ring, reads in flight */
+
+	void *rings;           /**< Both rings, in one mapping */
+	size_t rings_len;
+	size_t sqes_len;
+};
+
+
+static int uring_setup(unsigned entries, struct io_uring_params *params)
+{
+	return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+		       IORING_ENTER_GETEVENTS, NULL, 0);
+}
+
+bool io_uring_available()
+{
+	// 0 unknown, 1 available, 2 not
+	static atomic_int available;
+
+	int known = atomic_load(&available);
+	if (known)
+		return known == 1;
+
+	struct io_uring_params params = { .flags = 0 };
+	int fd = uring_setup(1, &params);
+
+	// plain reads came together with reads at the current position; both
+	// rings are mapped at once
+	bool ok = fd >= 0 && (params.features & IORING_FEAT_RW_CUR_POS) &&
+		(params.features & IORING_FEAT_SINGLE_MMAP);
+
+	if (fd >= 0)
+		close(fd);
+
+	atomic_store(&available, ok ? 1 : 2);
+	return ok;
+}
+
+/* a ring of at most entries, fewer if the kernel allows fewer */
+static bool uring_open(struct uring *ring, unsigned entries)
+{
+	struct io_uring_params params = { .flags = IORING_SETUP_CLAMP };
+
+	*ring = (struct uring) { .fd = uring_setup(entries, &params) };
+	if (ring->fd < 0)
+		return false;
+
+	size_t sq_len = params.sq_off.array +
+		params.sq_entries * sizeof(unsigned);
+	size_t cq_len = params.cq_off.cqes +
+		params.cq_entries * sizeof(struct io_uring_cqe);
+
+	// both rings share one mapping, see io_uring_available
+	ring->entries = params.sq_entries;
+	ring->rings_len = sq_len > cq_len ? sq_len : cq_len;
+	ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	ring->rings = mmap(NULL, ring->rings_len, PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_POPULATE, ring->fd,
+			   IORING_OFF_SQ_RING);
+	ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_POPULATE, ring->fd,
+			  IORING_OFF_SQES);
+
+	if (ring->rings == MAP_FAILED || ring->sqes == MAP_FAILED) {
+		if (ring->rings != MAP_FAILED)
+			munmap(ring->rings, ring->rings_len);
+		if (ring->sqes != MAP_FAILED)
+			munmap(ring->sqes, ring->sqes_len);
+		close(ring->fd);
+
+		return false;
+	}
+
+	char *sq = ring->rings, *cq = ring->rings;
+
+	ring->sq_tail = (unsigned *) (sq + params.sq_off.tail);
+	ring->sq_mask = (unsigned *) (sq + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned *) (sq + params.sq_off.array);
+
+	ring->cq_head = (unsigned *) (cq + params.cq_off.head);
+	ring->cq_tail = (unsigned *) (cq + params.cq_off.tail);
+	ring->cq_mask = (unsigned *) (cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+	return true;
+}
+
+static void uring_close(struct uring *ring)
+{
+	munmap(ring->sqes, ring->sqes_len);
+	munmap(ring->rings, ring->rings_len);
+	close(ring->fd);
+}
+
+/* queues a read of the next block of the file behind its carried bytes */
+static void queue_read(struct uring *ring, struct file_ingest *f)
+{
+	if (f->len + PAYLOAD_BLOCK_SIZE > f->cap) {
+		f->cap = f->len + PAYLOAD_BLOCK_SIZE;
+		f->data = realloc(f->data, f->cap);
+		assert(f->data);
+	}
+
+	// the tail is only written here, the kernel reads it
+	unsigned tail = *ring->sq_tail;
+	unsigned index = tail & *ring->sq_mask;
+
+	ring->sqes[index] = (struct io_uring_sqe) {
+		.opcode = IORING_OP_READ,
+		.fd = f->fd,
+		.off = f->offset,
+		.addr = (uintptr_t) (f->data + f->len),
+		.len = PAYLOAD_BLOCK_SIZE,
+		.user_data = (uintptr_t) f,
+	};
+	ring->sq_array[index] = index;
+
+	atomic_store_explicit((_Atomic unsigned *) ring->sq_tail, tail + 1,
+			      memory_order_release);
+	ring->to_submit++;
+}
+
+/* parses the whole lines that have arrived, or everything at the end */
+static void parse_arrived(struct file_ingest *f, bool at_end)
+{
+	size_t whole = f->len;
+
+	if (!at_end) {
+		const char *newline = memrchr(f->data, '\n', f->len);
+		whole = newline ? (size_t) (newline - f->data) + 1 : 0;
+	}
+
+	if (whole == 0)
+		return;
+
+	push_payloads_bulk(f->parsed, f->data, whole);
+
+	memmove(f->data, f->data + whole, f->len - whole);
+	f->len -= whole;
+}
+
+static void finish_file(struct file_ingest *f)
+{
+	close(f->fd);
+	free(f->data);
+	f->data = NULL;
+}
+
+bool push_payload_files_uring(struct payload_buffer *buf,
+			      const char *const *paths, int count, int depth)
+{
+	assert(buf->high_water == 0);
+
+	if (depth <= 0)
+		depth = INGEST_DEFAULT_DEPTH;
+	if (depth > count)
+		depth = count > 0 ? count : 1;
+
+	// out of memory, locked memory or entries, the threads do the reading
+	struct uring ring;
+	if (!io_uring_available() || !uring_open(&ring, depth))
+		return push_payload_files_threads(buf, paths, count, depth);
+
+	// one read in flight per file, and no more than the ring holds
+	if ((unsigned) depth > ring.entries)
+		depth = ring.entries;
+
+	struct file_ingest *files = calloc(count, sizeof(*files));
+	struct payload_buffer **parsed = calloc(count, sizeof(*parsed));
+	assert(files || count == 0);
+	assert(parsed || count == 0);
+
+	int next = 0, in_flight = 0;
+	bool failed = false;
+
+	for (;;) {
+		// files are opened as others finish, keeping few descriptors
+		while (!failed && next < count && in_flight < depth) {
+			struct file_ingest *f = &files[next];
+
+			f->fd = open(paths[next], O_RDONLY);
+			if (f->fd < 0) {
+				failed = true;
+				break;
+			}
+
+			f->parsed = parsed[next] = new_buffer();
+			queue_read(&ring, f);
+
+			next++;
+			in_flight++;
+		}
+
+		if (in_flight == 0)
+			break;
+
+		int submitted = uring_enter(ring.fd, ring.to_submit, 1);
+		if (submitted < 0) {
+			assert(errno == EINTR || errno == EAGAIN);
+			continue;
+		}
+		ring.to_submit -= submitted;
+
+		unsigned head = *ring.cq_head;
+		unsigned tail = atomic_load_explicit(
+			(_Atomic unsigned *) ring.cq_tail,
+			memory_order_acquire);
+
+		for (; head != tail; head++) {
+			struct io_uring_cqe *cqe =
+				&ring.cqes[head & *ring.cq_mask];
+			struct file_ingest *f =
+				(struct file_ingest *) (uintptr_t)
+				cqe->user_data;
+
+			if (cqe->res == -EINTR || cqe->res == -EAGAIN) {
+				queue_read(&ring, f);
+				continue;
+			}
+
+			// an error ends every file, no more is read then
+			if (cqe->res < 0)
+				failed = true;
+
+			if (cqe->res <= 0 || failed) {
+				if (!failed)
+					parse_arrived(f, true);
+
+				finish_file(f);
+				in_flight--;
+				continue;
+			}
+
+			f->len += cqe->res;
+			f->offset += cqe->res;
+
+			parse_arrived(f, false);
+			queue_read(&ring, f);
+		}
+
+		atomic_store_explicit((_Atomic unsigned *) ring.cq_head, head,
+				      memory_order_release);
+	}
+
+	uring_close(&ring);
+	free(files);
+
+	bool merged = merge_files(buf, parsed, next, failed);
+	free(parsed);
+
+	return merged;
+}
+
+
+/* thread pool */
+
+struct file_pool {
+	const char *const *paths;
+	int count;
+	struct payload_buffer **parsed;
+	atomic_int next;
+	atomic_bool failed;
+};
+
+
+static void *parse_files(void *arg)
+{
+	struct file_pool *pool = arg;
+	int i;
+
+	while (!atomic_load(&pool->failed) &&
+	       (i = atomic_fetch_add(&pool->next, 1)) < pool->count) {
+		struct payload_file file;
+
+		if (!map_payload_file(&file, pool->paths[i])) {
+			atomic_store(&pool->failed, true);
+			break;
+		}
+
+		struct payload_buffer *parsed = pool->parsed[i];
+		reserve_payloads(parsed, count_lines(&file));
+
+		const char *block;
+		size_t block_len, cursor = 0;
+
+		while (next_block(&file, &cursor, &block, &block_len))
+			push_payloads_bulk(parsed, block, block_len);
+
+		unmap_payload_file(&file);
+	}
+
+	return NULL;
+}
+
+bool push_payload_files_threads(struct payload_buffer *buf,
+				const char *const *paths, int count,
+				int depth)
+{
+	assert(buf->high_water == 0);
+
+	if (depth <= 0)
+		depth = INGEST_DEFAULT_DEPTH;
+	if (depth > count)
+		depth = count;
+
+	struct file_pool pool = {
+		.paths = paths,
+		.count = count,
+		.parsed = malloc(count * sizeof(struct payload_buffer *)),
+	};
+	assert(pool.parsed || count == 0);
+
+	for (int i = 0; i < count; i++)
+		pool.parsed[i] = new_buffer();
+
+	pthread_t *threads = malloc(depth * sizeof(pthread_t));
+	assert(threads || depth == 0);
+
+	// the calling thread is one of the pool
+	for (int t = 1; t < depth; t++) {
+		[[maybe_unused]] int created =
+			pthread_create(&threads[t], NULL, parse_files, &pool);
+		assert(created == 0);
+	}
+	if (depth > 0)
+		parse_files(&pool);
+
+	for (int t = 1; t < depth; t++)
+		pthread_join(threads[t], NULL);
+
+	free(threads);
+
+	bool merged = merge_files(buf, pool.parsed, count,
+				  atomic_load(&pool.failed));
+	free(pool.parsed);
+
+	return merged;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file multi_ingest.h
+ * @brief Parsing many payload files with reads for all of them in flight.
+ *
+ * Rotated traffic arrives as many files per batch. Reading them one after
+ * the other keeps a single read in flight; here up to depth files are read
+ * at once, so the storage queue stays full while completed blocks are
+ * parsed.
+ *
+ * With io_uring, every file being read has one read of PAYLOAD_BLOCK_SIZE
+ * bytes queued, and a single thread reaps completions and parses the whole
+ * lines of each block as it arrives. A line cut by the end of a block is
+ * carried over to the next one. Without io_uring, a pool of depth threads
+ * maps one file at a time each and parses it, blocking in page faults
+ * instead.
+ *
+ * Either way, every file is parsed into a buffer of its own and the buffers
+ * are appended to the target in the order of the paths, as if the files
+ * had been concatenated.
+ */
+
+
+#ifndef MULTI_INGEST_H
+#define MULTI_INGEST_H
+
+
+#include "dynamic_dispatch.h"
+
+#include <stdbool.h>
+
+
+/** @brief Files read at once when no depth is given. */
+#define INGEST_DEFAULT_DEPTH 32
+
+
+/**
+ * @brief Whether the kernel provides io_uring with the read operation and
+ *        both rings in a single mapping.
+ *
+ * Checked once, the result is cached.
+ */
+bool io_uring_available();
+
+/**
+ * @brief Parses the files at paths into buf, through io_uring if available.
+ *
+ * Invalid commands are reported while parsing, possibly out of order. If
+ * buf has a log, the payloads are appended to it in order during the merge.
+ *
+ * @param buf Buffer to append to, not in streaming mode
+ * @param paths Paths of the payload files
+ * @param count Number of paths
+ * @param depth Files read at once, 0 for INGEST_DEFAULT_DEPTH
+ * @return False if a file cannot be opened or read, buf is unchanged then
+ */
+bool push_payload_files(struct payload_buffer *buf, const char *const *paths,
+			int count, int depth);
+
+/**
+ * @brief push_payload_files() through io_uring.
+ *
+ * Falls back to push_payload_files_threads() if io_uring is not available
+ * or a ring cannot be set up. The ring is clamped to the entries the kernel
+ * allows, and depth with it.
+ */
+bool push_payload_files_uring(struct payload_buffer *buf,
+			      const char *const *paths, int count, int depth);
+
+/**
+ * @brief push_payload_files() on a pool of depth threads.
+ */
+bool push_payload_files_threads(struct payload_buffer *buf,
+				const char *const *paths, int count,
+				int depth);
+
+
+#endif
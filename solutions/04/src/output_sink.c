@@ -0,0 +1,273 @@
+#include "output_sink.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+
+/* writes every byte described by iov, retrying after short writes */
+static void write_all(int fd, struct iovec *iov, int count)
+{
+	while (count > 0) {
+		ssize_t written = writev(fd, iov, count);
+
+		if (written < 0 && errno == EINTR)
+			continue;
+		assert(written >= 0);
+
+		while (count > 0 && (size_t) written >= iov->iov_len) {
+			written -= iov->iov_len;
+			iov++;
+			count--;
+		}
+
+		if (count > 0) {
+			iov->iov_base = (char *) iov->iov_base + written;
+			iov->iov_len -= written;
+		}
+	}
+}
+
+static void *drain(void *arg)
+{
+	struct output_sink *sink = arg;
+
+	pthread_mutex_lock(&sink->lock);
+
+	for (;;) {
+		while (!sink->busy && !sink->closing)
+			pthread_cond_wait(&sink->changed, &sink->lock);
+
+		if (!sink->busy)
+			break;
+
+		// the spare buffer is ours until busy is cleared
+		pthread_mutex_unlock(&sink->lock);
+
+		struct iovec iov = {
+			.iov_base = sink->spare,
+			.iov_len = sink->spare_len,
+		};
+		write_all(sink->fd, &iov, 1);
+
+		pthread_mutex_lock(&sink->lock);
+		sink->busy = false;
+		pthread_cond_broadcast(&sink->changed);
+	}
+
+	pthread_mutex_unlock(&sink->lock);
+
+	return NULL;
+}
+
+/* waits until the writer thread has written the spare buffer */
+static void wait_idle(struct output_sink *sink)
+{
+	pthread_mutex_lock(&sink->lock);
+	while (sink->busy)
+		pthread_cond_wait(&sink->changed, &sink->lock);
+	pthread_mutex_unlock(&sink->lock);
+}
+
+/* hands the filled buffer to the writer thread and continues in the spare */
+static void submit(struct output_sink *sink)
+{
+	wait_idle(sink);
+
+	pthread_mutex_lock(&sink->lock);
+
+	char *filled = sink->buf;
+	sink->buf = sink->spare;
+	sink->spare = filled;
+	sink->spare_len = sink->len;
+	sink->len = 0;
+
+	sink->busy = true;
+	pthread_cond_broadcast(&sink->changed);
+
+	pthread_mutex_unlock(&sink->lock);
+}
+
+/* writes the buffer followed by data, which may be NULL */
+static void drain_with(struct output_sink *sink, const char *data, size_t len)
+{
+	if (sink->len == 0 && len == 0)
+		return;
+
+	if (sink->async) {
+		if (sink->len > 0)
+			submit(sink);
+
+		if (len == 0)
+			return;
+
+		// earlier output must be written first
+		wait_idle(sink);
+
+		struct iovec iov = {
+			.iov_base = (char *) data,
+			.iov_len = len,
+		};
+		write_all(sink->fd, &iov, 1);
+
+		return;
+	}
+
+	// one syscall for both the buffer and data
+	struct iovec iov[2] = {
+		{ .iov_base = sink->buf, .iov_len = sink->len },
+		{ .iov_base = (char *) data, .iov_len = len },
+	};
+
+	write_all(sink->fd, iov, 2);
+	sink->len = 0;
+}
+
+void sink_open(struct output_sink *sink, int fd, size_t cap, bool async)
+{
+	if (cap == 0)
+		cap = OUTPUT_SINK_DEFAULT_CAP;
+
+	*sink = (struct output_sink) {
+		.fd = fd,
+		.buf = malloc(cap),
+		.cap = cap,
+		.async = async,
+	};
+	assert(sink->buf);
+
+	if (async) {
+		sink->spare = malloc(cap);
+		assert(sink->spare);
+
+		pthread_mutex_init(&sink->lock, NULL);
+		pthread_cond_init(&sink->changed, NULL);
+
+		// outside the assert, which NDEBUG removes with its argument
+		[[maybe_unused]] int created =
+			pthread_create(&sink->writer, NULL, drain, sink);
+		assert(created == 0);
+	}
+}
+
+void sink_write(struct output_sink *sink, const char *data, size_t len)
+{
+	if (sink == NULL) {
+		fwrite(data, 1, len, stdout);
+		return;
+	}
+
+	if (len <= sink->cap - sink->len) {
+		memcpy(sink->buf + sink->len, data, len);
+		sink->len += len;
+
+		return;
+	}
+
+	if (len < sink->cap) {
+		if (sink->async)
+			submit(sink);
+		else
+			drain_with(sink, NULL, 0);
+
+		memcpy(sink->buf, data, len);
+		sink->len = len;
+
+		return;
+	}
+
+	// too large to be worth copying
+	drain_with(sink, data, len);
+}
+
+void sink_puts(struct output_sink *sink, const char *str)
+{
+	sink_write(sink, str, strlen(str));
+}
+
+void sink_printf(struct output_sink *sink, const char *fmt, ...)
+{
+	va_list args;
+
+	if (sink == NULL) {
+		va_start(args, fmt);
+		vprintf(fmt, args);
+		va_end(args);
+
+		return;
+	}
+
+	size_t room = sink->cap - sink->len;
+
+	va_start(args, fmt);
+	int n = vsnprintf(sink->buf + sink->len, room, fmt, args);
+	va_end(args);
+	assert(n >= 0);
+
+	if ((size_t) n < room) {
+		sink->len += n;
+		return;
+	}
+
+	// did not fit, format again into a fresh buffer
+	if ((size_t) n < sink->cap) {
+		if (sink->async)
+			submit(sink);
+		else
+			drain_with(sink, NULL, 0);
+
+		va_start(args, fmt);
+		vsnprintf(sink->buf, sink->cap, fmt, args);
+		va_end(args);
+		sink->len = n;
+
+		return;
+	}
+
+	char *formatted = malloc(n + 1);
+	assert(formatted);
+
+	va_start(args, fmt);
+	vsnprintf(formatted, n + 1, fmt, args);
+	va_end(args);
+
+	drain_with(sink, formatted, n);
+	free(formatted);
+}
+
+void sink_flush(struct output_sink *sink)
+{
+	if (sink == NULL) {
+		fflush(stdout);
+		return;
+	}
+
+	drain_with(sink, NULL, 0);
+
+	if (sink->async)
+		wait_idle(sink);
+}
+
+void sink_close(struct output_sink *sink)
+{
+	sink_flush(sink);
+
+	if (sink->async) {
+		pthread_mutex_lock(&sink->lock);
+		sink->closing = true;
+		pthread_cond_broadcast(&sink->changed);
+		pthread_mutex_unlock(&sink->lock);
+
+		pthread_join(sink->writer, NULL);
+		pthread_mutex_destroy(&sink->lock);
+		pthread_cond_destroy(&sink->changed);
+		free(sink->spare);
+	}
+
+	free(sink->buf);
+	sink->buf = sink->spare = NULL;
+}
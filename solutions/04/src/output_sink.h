@@ -0,0 +1,98 @@
+/**
+ * @file output_sink.h
+ * @brief Buffered output for the behaviors.
+ *
+ * Behaviors print a few short lines per payload. Written one by one, every
+ * line can cost a syscall. A sink collects them in a large buffer and writes
+ * it out in one go once it is full, with writev when a write does not fit.
+ *
+ * An asynchronous sink owns a second buffer and a writer thread. While the
+ * writer thread drains one buffer, the behaviors fill the other.
+ */
+
+
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/** @brief Buffer size used when none is given. */
+#define OUTPUT_SINK_DEFAULT_CAP ((size_t) 1 << 16)
+
+
+/**
+ * @brief Buffered writer to a file descriptor.
+ *
+ * A sink is not thread-safe: only one thread may write to it at a time.
+ * In async mode, the writer thread is internal and needs no extra care.
+ */
+struct output_sink {
+	int fd;
+	char *buf;          /**< Buffer being filled */
+	size_t len;
+	size_t cap;
+
+	bool async;
+	char *spare;        /**< Buffer being written by the writer thread */
+	size_t spare_len;
+	bool busy;          /**< spare holds data not written yet */
+	bool closing;
+	pthread_t writer;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+};
+
+
+/**
+ * @brief Opens a sink writing to fd.
+ *
+ * @param sink Sink to initialize
+ * @param fd Descriptor to write to, stays open after sink_close
+ * @param cap Buffer size in bytes, 0 for OUTPUT_SINK_DEFAULT_CAP
+ * @param async Whether a background thread does the writing
+ */
+void sink_open(struct output_sink *sink, int fd, size_t cap, bool async);
+
+/**
+ * @brief Appends len bytes of data.
+ *
+ * A NULL sink writes to stdout through stdio instead.
+ */
+void sink_write(struct output_sink *sink, const char *data, size_t len);
+
+/**
+ * @brief Appends a NUL-terminated string.
+ *
+ * Cheaper than sink_printf, which parses its format on every call and
+ * formats a second time when the output does not fit the room left. A NULL
+ * sink writes to stdout through stdio instead.
+ */
+void sink_puts(struct output_sink *sink, const char *str);
+
+/**
+ * @brief Appends formatted output, like printf.
+ *
+ * Formats with vsnprintf straight into the buffer. Output that does not fit
+ * is formatted again after a flush, or into a temporary buffer if it is
+ * larger than the whole sink. A NULL sink writes to stdout through stdio
+ * instead.
+ */
+void sink_printf(struct output_sink *sink, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Writes everything buffered so far and waits until it is written.
+ */
+void sink_flush(struct output_sink *sink);
+
+/**
+ * @brief Flushes the sink, stops its writer thread and frees its buffers.
+ */
+void sink_close(struct output_sink *sink);
+
+
+#endif
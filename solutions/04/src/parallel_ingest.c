@@ -0,0 +1,110 @@
+#include "parallel_ingest.h"
+#include "payload.h"
+#include "payload_log.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+struct worker {
+	pthread_t thread;
+	struct payload_file chunk;
+	struct payload_buffer *parsed;
+};
+
+
+static void *parse_chunk(void *arg)
+{
+	struct worker *w = arg;
+
+	// sized once from the line count instead of doubling all the way
+	reserve_payloads(w->parsed, count_lines(&w->chunk));
+
+	const char *block;
+	size_t block_len, cursor = 0;
+
+	// one scan over each block finds every newline, space and sigil,
+	// lines are parsed from the index afterwards
+	while (next_block(&w->chunk, &cursor, &block, &block_len))
+		push_payloads_bulk(w->parsed, block, block_len);
+
+	return NULL;
+}
+
+void push_payloads_parallel(struct payload_buffer *buf,
+			    const struct payload_file *file, int workers)
+{
+	assert(buf->high_water == 0);
+
+	if (workers <= 0)
+		workers = sysconf(_SC_NPROCESSORS_ONLN);
+	if (workers <= 0)
+		workers = 1;
+
+	struct payload_file *chunks = malloc(workers * sizeof(*chunks));
+	struct worker *pool = malloc(workers * sizeof(*pool));
+	assert(chunks && pool);
+
+	int count = split_payload_file(file, workers, chunks);
+
+	for (int i = 0; i < count; i++) {
+		pool[i] = (struct worker) {
+			.chunk = chunks[i],
+			.parsed = new_buffer(),
+		};
+
+		// the calling thread takes the last chunk itself
+		if (i < count - 1) {
+			[[maybe_unused]] int created = pthread_create(
+				&pool[i].thread, NULL, parse_chunk, &pool[i]);
+			assert(created == 0);
+		} else {
+			parse_chunk(&pool[i]);
+		}
+	}
+
+	int total = 0;
+
+	for (int i = 0; i < count; i++) {
+		if (i < count - 1)
+			pthread_join(pool[i].thread, NULL);
+
+		total += pool[i].parsed->len;
+	}
+
+	// a single chunk into an empty buffer hands its array over instead
+	bool hand_over = count == 1 && buf->len == 0;
+
+	if (!hand_over)
+		reserve_payloads(buf, total);
+
+	// merge in file order
+	for (int i = 0; i < count; i++) {
+		struct payload_buffer *parsed = pool[i].parsed;
+		struct payload *merged = &buf->payloads[buf->len];
+
+		if (hand_over) {
+			merged = parsed->payloads;
+			parsed->payloads = buf->payloads;
+			buf->payloads = merged;
+			buf->cap = parsed->cap;
+		} else {
+			memcpy(merged, parsed->payloads,
+			       parsed->len * sizeof(struct payload));
+		}
+		buf->len += parsed->len;
+
+		for (int k = 0; buf->log && k < parsed->len; k++)
+			log_payload(buf->log, &merged[k]);
+
+		arena_adopt(&buf->strings, &parsed->strings);
+		destroy(parsed);
+	}
+
+	free(pool);
+	free(chunks);
+}
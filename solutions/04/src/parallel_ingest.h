@@ -0,0 +1,38 @@
+/**
+ * @file parallel_ingest.h
+ * @brief Parsing one payload file on several threads.
+ */
+
+
+#ifndef PARALLEL_INGEST_H
+#define PARALLEL_INGEST_H
+
+
+#include "dynamic_dispatch.h"
+#include "payload_file.h"
+
+
+/**
+ * @brief Parses every line of file into buf using up to workers threads.
+ *
+ * The file is split into one chunk of whole lines per worker. Each worker
+ * parses its chunk into a buffer of its own, and the buffers are appended to
+ * buf in file order afterwards, so buf ends up exactly as if the lines had
+ * been pushed one by one. Strings are not copied during the merge, the arenas
+ * of the workers are handed over to buf. Workers size their arrays from the
+ * line count of their chunk and buf is grown once for all of them, or simply
+ * takes over the array of a single worker.
+ *
+ * Invalid commands are reported by the worker that finds them, so these
+ * messages may come out of order. If buf has a log, the payloads are
+ * appended to it in file order during the merge.
+ *
+ * @param buf Buffer to append to, not in streaming mode
+ * @param file Mapped payload file
+ * @param workers Number of threads, 0 for one per online CPU
+ */
+void push_payloads_parallel(struct payload_buffer *buf,
+			    const struct payload_file *file, int workers);
+
+
+#endif
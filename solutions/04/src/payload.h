@@ -8,34 +8,48 @@
 #define PAYLOAD_H
 
 
+#include "structural_index.h"
+
 #include <stdbool.h>
 
 
+struct arena;
+struct output_sink;
+
+
 struct message_receiving_entity {
 	const struct message_receiving_entity_vtable *vtable;
-	char *additional_info;
+	const char *additional_info;  /**< Interned name, NULL if global */
 };
 
 struct message_receiving_entity_vtable {
 	void (*transmit_message)(const struct message_receiving_entity *self,
 				 const char *content);
-	void (*destroy)(const struct message_receiving_entity *self);
 };
 
+/* Receivers a message holds without allocating. Most messages have one, the
+ * rest go to an array in the arena. */
+#define MESSAGE_INLINE_RECEIVERS 1
+
 union payload_data {
 	struct {
-		char *username;
+		const char *username;  /**< Interned */
 		char *password;
 	} command_login;
 
 	struct {
-		char *channel;
+		const char *channel;   /**< Interned */
 	} command_join;
 
 	struct {
-		struct message_receiving_entity *receivers;
 		char *content;
 		int receiver_count;
+		// read through message_receivers
+		union {
+			struct message_receiving_entity
+				inline_receivers[MESSAGE_INLINE_RECEIVERS];
+			struct message_receiving_entity *receivers;
+		};
 	} message;
 };
 
@@ -46,11 +60,68 @@ struct payload {
 
 struct payload_vtable {
 	void (*process)(const struct payload *self);
-	void (*destroy)(const struct payload *self);
+
+	// bytes of payload_data the payload uses, the leading part of its
+	// union member
+	size_t data_size;
+
+	// i-th user or channel name the payload concerns, interned, NULL past
+	// the last one. Batching keeps payloads sharing a name in order.
+	// Logins and joins also name the session they change or act for.
+	// Payloads without this method concern every user and are never
+	// reordered.
+	const char *(*name)(const struct payload *self, int i);
+};
+
+
+/**
+ * @brief Receivers of a message, held inline up to MESSAGE_INLINE_RECEIVERS.
+ *
+ * Inline receivers move with the payload, so their address is only stable
+ * while the payload stays put.
+ */
+static inline const struct message_receiving_entity *
+message_receivers(const union payload_data *data)
+{
+	return data->message.receiver_count <= MESSAGE_INLINE_RECEIVERS ?
+		data->message.inline_receivers : data->message.receivers;
+}
+
+
+/**
+ * @brief Position in a line while walking its structural marks.
+ */
+struct line_cursor {
+	const struct payload_line *line;
+	uint32_t offset;  /**< Next unread byte */
+	size_t mark;      /**< Next unread mark */
 };
 
 
-bool parse_payload(struct payload *p, const char *raw);
+/**
+ * @brief Copies the token under the cursor and moves past the next space.
+ *
+ * @return The token allocated from strings, NULL if the token is empty
+ */
+char *extract_token(struct line_cursor *c, struct arena *strings);
+
+/**
+ * @brief Interns the token under the cursor and moves past the next space.
+ *
+ * @return The interned token, NULL if the token is empty
+ */
+const char *intern_token(struct line_cursor *c);
+
+/**
+ * @brief Parses one line into a payload, setting up its vtable.
+ *
+ * @param p Output for parsed payload
+ * @param line Line to parse, tokens are found through its structural marks
+ * @param strings Arena every string and receiver array is allocated from,
+ *                payloads need no cleanup of their own
+ */
+bool parse_payload(struct payload *p, const struct payload_line *line,
+		   struct arena *strings);
 
 
 /* payload vtables */
@@ -64,5 +135,10 @@ extern const struct message_receiving_entity_vtable direct_message_vtable;
 extern const struct message_receiving_entity_vtable group_message_vtable;
 extern const struct message_receiving_entity_vtable global_message_vtable;
 
+/* Sink the behaviors and the parse errors of the calling thread write to,
+ * stdout through stdio while NULL. Each thread has its own, as a sink is not
+ * thread-safe. */
+extern _Thread_local struct output_sink *payload_output;
+
 
 #endif
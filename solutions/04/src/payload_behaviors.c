@@ -1,36 +1,86 @@
 // "behavioral" functions
 
+#include "channel_registry.h"
+#include "intern.h"
+#include "output_sink.h"
 #include "payload.h"
+#include "session_table.h"
 
-#include <stdio.h>
-#include <stdlib.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+
+// pieces are appended one by one, formatting with printf costs more than
+// the copying itself
+_Thread_local struct output_sink *payload_output = NULL;
+
+// user of the last login, NULL before the first one and after a logout.
+// Joins act on its behalf, logout closes its session.
+static _Atomic(const char *) current_user;
+
+
+// Name shared by every payload reading or changing current_user, keeping
+// them in order when batched. Tokens never contain a space, so no user or
+// channel has this name.
+static const char *session_name()
+{
+	static _Atomic(const char *) name;
+	const char *found = atomic_load_explicit(&name, memory_order_acquire);
+
+	if (found == NULL) {
+		found = intern(" session", 8);
+		atomic_store_explicit(&name, found, memory_order_release);
+	}
+
+	return found;
+}
 
 
 void process_command_login(const struct payload *self)
 {
-	printf("Command: login\n"
-	       "  Arguments: [username: %s, password %s]\n",
-	       self->data.command_login.username,
-	       self->data.command_login.password);
+	struct output_sink *out = payload_output;
+
+	sink_puts(out, "Command: login\n  Arguments: [username: ");
+	sink_puts(out, self->data.command_login.username);
+	sink_puts(out, ", password ");
+	sink_puts(out, self->data.command_login.password);
+	sink_puts(out, "]\n");
+
+	open_session(self->data.command_login.username);
+	atomic_store_explicit(&current_user, self->data.command_login.username,
+			      memory_order_release);
 }
 
 void process_command_join(const struct payload *self)
 {
-	printf("Command: join\n"
-	       "  Arguments: [channel: %s]\n",
-	       self->data.command_join.channel);
+	struct output_sink *out = payload_output;
+
+	sink_puts(out, "Command: join\n  Arguments: [channel: ");
+	sink_puts(out, self->data.command_join.channel);
+	sink_puts(out, "]\n");
+
+	const char *user = atomic_load_explicit(&current_user,
+						memory_order_acquire);
+	if (user)
+		join_channel(self->data.command_join.channel, user);
 }
 
 void process_command_logout([[maybe_unused]] const struct payload *self)
 {
-	printf("Command: logout\n"
-	       "  Arguments: []\n");
+	sink_puts(payload_output, "Command: logout\n  Arguments: []\n");
+
+	const char *user = atomic_exchange_explicit(&current_user, NULL,
+						    memory_order_acq_rel);
+	if (user) {
+		leave_channels(user);
+		close_session(user);
+	}
 }
 
 void process_message(const struct payload *self)
 {
-	struct message_receiving_entity *receivers = \
-		self->data.message.receivers;
+	const struct message_receiving_entity *receivers = \
+		message_receivers(&self->data);
 
 	for (int i = 0; i < self->data.message.receiver_count; i++)
 		receivers[i].vtable->transmit_message(&receivers[i],
@@ -40,90 +90,105 @@ void process_message(const struct payload *self)
 void transmit_direct_message(const struct message_receiving_entity *self,
 			     const char *content)
 {
-	printf("Direct message to %s: %s\n", self->additional_info, content);
+	struct output_sink *out = payload_output;
+
+	sink_puts(out, "Direct message to ");
+	sink_puts(out, self->additional_info);
+	sink_puts(out, ": ");
+	sink_puts(out, content);
+	sink_puts(out, "\n");
+
+	if (!is_online(self->additional_info)) {
+		sink_puts(out, "  Not delivered, ");
+		sink_puts(out, self->additional_info);
+		sink_puts(out, " is offline\n");
+	}
+}
+
+static void deliver_group_message(const char *user, void *out)
+{
+	sink_puts(out, "  Delivered to ");
+	sink_puts(out, user);
+	sink_puts(out, "\n");
 }
 
 void transmit_group_message(const struct message_receiving_entity *self,
 			    const char *content)
 {
-	printf("Group message to %s: %s\n", self->additional_info, content);
+	struct output_sink *out = payload_output;
+
+	sink_puts(out, "Group message to ");
+	sink_puts(out, self->additional_info);
+	sink_puts(out, ": ");
+	sink_puts(out, content);
+	sink_puts(out, "\n");
+
+	for_each_member(self->additional_info, deliver_group_message, out);
 }
 
 void transmit_global_message([[maybe_unused]] const struct message_receiving_entity *self,
 			     const char *content)
 {
-	printf("Global message: %s\n", content);
-}
-
+	struct output_sink *out = payload_output;
 
-void destroy_command_login(const struct payload *self)
-{
-	free(self->data.command_login.username);
-	free(self->data.command_login.password);
+	sink_puts(out, "Global message: ");
+	sink_puts(out, content);
+	sink_puts(out, "\n");
 }
 
-void destroy_command_join(const struct payload *self)
+
+const char *name_command_login(const struct payload *self, int i)
 {
-	free(self->data.command_join.channel);
+	return i == 0 ? self->data.command_login.username :
+		i == 1 ? session_name() : NULL;
 }
 
-void destroy_command_logout([[maybe_unused]] const struct payload *self)
-{}
-
-void destroy_message(const struct payload *self)
+const char *name_command_join(const struct payload *self, int i)
 {
-	struct message_receiving_entity *receivers = \
-		self->data.message.receivers;
-
-	for (int i = 0; i < self->data.message.receiver_count; i++)
-		receivers[i].vtable->destroy(&receivers[i]);
-
-	free(self->data.message.content);
-	free(receivers);
+	return i == 0 ? self->data.command_join.channel :
+		i == 1 ? session_name() : NULL;
 }
 
-void destroy_global_message([[maybe_unused]] const struct message_receiving_entity *self)
-{}
-
-void destroy_group_or_direct_message(const struct message_receiving_entity *self)
+const char *name_message(const struct payload *self, int i)
 {
-	free(self->additional_info);
+	// global messages have a single receiver without a name
+	return i < self->data.message.receiver_count ?
+		message_receivers(&self->data)[i].additional_info : NULL;
 }
 
 
 /* payload vtables */
 const struct payload_vtable command_login_vtable = {
 	.process = process_command_login,
-	.destroy = destroy_command_login,
+	.data_size = sizeof(((union payload_data *) 0)->command_login),
+	.name = name_command_login,
 };
 
 const struct payload_vtable command_join_vtable = {
 	.process = process_command_join,
-	.destroy = destroy_command_join,
+	.data_size = sizeof(((union payload_data *) 0)->command_join),
+	.name = name_command_join,
 };
 
 const struct payload_vtable command_logout_vtable = {
 	.process = process_command_logout,
-	.destroy = destroy_command_logout,
 };
 
 const struct payload_vtable message_vtable = {
 	.process = process_message,
-	.destroy = destroy_message,
+	.data_size = sizeof(((union payload_data *) 0)->message),
+	.name = name_message,
 };
 
 /* receiver vtables */
 const struct message_receiving_entity_vtable direct_message_vtable = {
 	.transmit_message = transmit_direct_message,
-	.destroy = destroy_group_or_direct_message,
 };
 
 const struct message_receiving_entity_vtable group_message_vtable = {
 	.transmit_message = transmit_group_message,
-	.destroy = destroy_group_or_direct_message,
 };
 
 const struct message_receiving_entity_vtable global_message_vtable = {
 	.transmit_message = transmit_global_message,
-	.destroy = destroy_global_message,
 };
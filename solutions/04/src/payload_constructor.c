@@ -12,142 +12,205 @@
 // parsers (http://github.com/metwse/rdesc)
 
 #include "payload.h"
+#include "arena.h"
+#include "command_registry.h"
+#include "intern.h"
+#include "output_sink.h"
 
+#include <stdalign.h>
 #include <stdbool.h>
-#include <stdio.h>
-#include <stdlib.h>
 #include <assert.h>
-#include <string.h>
+#include <pthread.h>
 
 
-static char *extract_token(const char *raw) {
-	int end;
-	char *token;
+/* offset of the next space after the cursor, or the line end if none */
+static uint32_t next_space(struct line_cursor *c)
+{
+	const struct payload_line *line = c->line;
+
+	// marks are sigils or spaces, only the byte at the mark tells which
+	while (c->mark < line->mark_count) {
+		uint32_t offset = line->marks[c->mark++];
+
+		if (line->block[offset] == ' ')
+			return offset;
+	}
+
+	return line->end;
+}
 
-	for (end = 0; raw[end] != ' ' && raw[end] != '\0'; end++);
+/* span until the next space, and advance cursor past that space */
+static uint32_t next_token(struct line_cursor *c, uint32_t *start)
+{
+	*start = c->offset;
+
+	uint32_t stop = next_space(c);
+	c->offset = stop < c->line->end ? stop + 1 : stop;
+
+	return stop;
+}
+
+char *extract_token(struct line_cursor *c, struct arena *strings)
+{
+	uint32_t start, stop = next_token(c, &start);
 
-	if (end == 0) {
+	if (stop == start)
 		return NULL;
-	} else {
-		token = malloc(sizeof(char) * (end + 1));
-		assert(token);
-		token[end] = '\0';
+	else
+		return arena_strndup(strings, c->line->block + start,
+				     stop - start);
+}
 
-		for (int i = 0; i < end; i++)
-			token[i] = raw[i];
+const char *intern_token(struct line_cursor *c)
+{
+	uint32_t start, stop = next_token(c, &start);
 
-		return token;
-	}
+	if (stop == start)
+		return NULL;
+	else
+		return intern(c->line->block + start, stop - start);
 }
 
-static void message_constructor(struct payload *p, const char *raw)
+static bool at_receiver(const struct line_cursor *c)
+{
+	return c->offset < c->line->end &&
+		(c->line->block[c->offset] == '@' ||
+		 c->line->block[c->offset] == '#');
+}
+
+static void message_constructor(struct payload *p,
+				const struct payload_line *line,
+				struct arena *strings)
 {
 	p->vtable = &message_vtable;
 
-	// Nested polymorphism: each receiver is polymorphic!
-	// They can be direct (@user), group (#channel), or global (no prefix)
-	// Each receiver knows how to transmit and destroy itself shorthand
-	// variable for receivers field
-	struct message_receiving_entity *receivers;
-	assert((receivers = malloc(sizeof(struct message_receiving_entity))));
+	struct line_cursor cursor = { .line = line, .offset = line->start };
+	uint32_t start;
 
+	// Receivers are counted up front, so they either fit in the payload
+	// or the array is allocated from the arena once instead of growing it
+	// receiver by receiver.
 	int receiver_count = 0;
 
-	int content_offset = 0;
-	while (raw[content_offset] == '@' || raw[content_offset] == '#') {
-		int name_end;
-		// assuming all payloads are valid (all of the payloads have
-		// message content)
-		for (name_end = content_offset;
-		     raw[name_end] != ' '; name_end++);
-
-		char *receiver_name = malloc(sizeof(char) *
-					     (name_end - content_offset));
+	for (struct line_cursor c = cursor; at_receiver(&c); receiver_count++)
+		next_token(&c, &start);
 
-		for (int i = content_offset + 1; raw[i] != ' '; i++)
-			receiver_name[i - content_offset - 1] = raw[i];
-
-		receiver_name[name_end - content_offset - 1] = '\0';
+	// Nested polymorphism: each receiver is polymorphic!
+	// They can be direct (@user), group (#channel), or global (no prefix)
+	// Each receiver knows how to transmit itself
+	struct message_receiving_entity *receivers = \
+		p->data.message.inline_receivers;
+
+	if (receiver_count > MESSAGE_INLINE_RECEIVERS) {
+		receivers = arena_alloc(strings,
+			sizeof(struct message_receiving_entity) *
+			receiver_count,
+			alignof(struct message_receiving_entity));
+		p->data.message.receivers = receivers;
+	}
 
-		if (receiver_count >= 1) {
-			assert((receivers = realloc(receivers,
-				sizeof(struct message_receiving_entity) *
-			        (receiver_count + 1))));
-		}
+	for (int i = 0; i < receiver_count; i++) {
+		// a receiver without message content runs until the end of
+		// the line
+		uint32_t stop = next_token(&cursor, &start);
 
-		receivers[receiver_count] = (struct message_receiving_entity) {
-			.additional_info = receiver_name,
+		receivers[i] = (struct message_receiving_entity) {
+			.additional_info = intern(line->block + start + 1,
+						  stop - start - 1),
 			.vtable = \
-				raw[content_offset] == '@' ?
+				line->block[start] == '@' ?
 				&direct_message_vtable : &group_message_vtable,
 		};
-
-		receiver_count++;
-
-		content_offset = name_end + 1;
 	}
 
 	// fallback to global message if no receiver found
-	if (content_offset == 0) {
+	if (receiver_count == 0) {
 		receivers->vtable = &global_message_vtable;
+		receivers->additional_info = NULL;
 		receiver_count = 1;
 	};
 
+	p->data.message.content = arena_strndup(strings,
+		line->block + cursor.offset, line->end - cursor.offset);
+	p->data.message.receiver_count = receiver_count;
+}
 
-	assert((p->data.message.content =
-		malloc(sizeof(char) * (strlen(raw) - content_offset + 1))));
+static void command_login_constructor(union payload_data *data,
+				     struct line_cursor *args,
+				     struct arena *strings)
+{
+	data->command_login.username = intern_token(args);
+	data->command_login.password = extract_token(args, strings);
+	assert(data->command_login.username);
+	assert(data->command_login.password);
+}
 
-	strcpy(p->data.message.content, raw + content_offset);
-	p->data.message.receivers = receivers;
-	p->data.message.receiver_count = receiver_count;
+static void command_join_constructor(union payload_data *data,
+				    struct line_cursor *args,
+				    [[maybe_unused]] struct arena *strings)
+{
+	data->command_join.channel = intern_token(args);
+	assert(data->command_join.channel);
+}
+
+// Adding a command is one more entry here, no parser code changes.
+static const struct command commands[] = {
+	{
+		.name = "login",
+		.vtable = &command_login_vtable,
+		.construct = command_login_constructor,
+	},
+	{
+		.name = "join",
+		.vtable = &command_join_vtable,
+		.construct = command_join_constructor,
+	},
+	{
+		.name = "logout",
+		.vtable = &command_logout_vtable,
+	},
+};
+
+static struct command_registry registry;
+static pthread_once_t registry_once = PTHREAD_ONCE_INIT;
+
+static void init_registry()
+{
+	build_command_registry(&registry, commands,
+			       sizeof(commands) / sizeof(*commands));
 }
 
-bool parse_payload(struct payload *p, const char *raw)
+bool parse_payload(struct payload *p, const struct payload_line *line,
+		   struct arena *strings)
 {
-	// PAIN, but separated
-	if (raw[0] == '/') {
-		char command_name[7];
-
-		int i;
-
-		for (i = 0; i < 6 && raw[i + 1] != ' '; i++)
-			command_name[i] = raw[i + 1];
-
-		command_name[i] = '\0';
-
-		if (strcmp("login", command_name) == 0) {
-			char *username, *password;
-			assert((username = extract_token(raw + 7)));
-			assert((password = extract_token(
-				raw + strlen(username) + 8)));
-
-			*p = (struct payload) {
-				.vtable = &command_login_vtable,
-				.data.command_login = {
-					.username = username,
-					.password = password
-				}
-			};
-		} else if (strcmp("join", command_name) == 0) {
-			char *channel;
-			assert((channel = extract_token(raw + 6)));
-
-			*p = (struct payload) {
-				.vtable = &command_join_vtable,
-				.data.command_join = {
-					.channel = channel,
-				}
-			};
-		} else if (strcmp("logout", command_name) == 0) {
-			*p = (struct payload) {
-				.vtable = &command_logout_vtable
-			};
-		} else {
-			printf("Ignoring invalid command %s\n", command_name);
+	if (line->start < line->end && line->block[line->start] == '/') {
+		struct line_cursor cursor = {
+			.line = line,
+			.offset = line->start + 1,
+		};
+
+		uint32_t start, stop = next_token(&cursor, &start);
+
+		pthread_once(&registry_once, init_registry);
+
+		const struct command *command = find_command(
+			&registry, line->block + start, stop - start);
+
+		// through the sink the behaviors write to, keeping the
+		// report among the output of the payloads around it
+		if (command == NULL) {
+			sink_printf(payload_output,
+				    "Ignoring invalid command %.*s\n",
+				    (int) (stop - start), line->block + start);
 			return false;
 		}
+
+		p->vtable = command->vtable;
+
+		if (command->construct)
+			command->construct(&p->data, &cursor, strings);
 	} else {
-		message_constructor(p, raw);
+		message_constructor(p, line, strings);
 	}
 
 	return true;
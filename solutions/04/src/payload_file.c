@@ -0,0 +1,168 @@
+// memrchr
+#define _GNU_SOURCE
+
+#include "payload_file.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+bool map_payload_file(struct payload_file *file, const char *path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return false;
+	}
+
+	file->len = st.st_size;
+	file->data = NULL;
+
+	// mmap refuses zero-length mappings, an empty file simply has no lines
+	if (file->len > 0) {
+		void *data = mmap(NULL, file->len, PROT_READ, MAP_PRIVATE,
+				  fd, 0);
+
+		if (data == MAP_FAILED) {
+			close(fd);
+			return false;
+		}
+
+		// lines are consumed front to back exactly once
+		madvise(data, file->len, MADV_SEQUENTIAL);
+		file->data = data;
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	close(fd);
+
+	return true;
+}
+
+bool next_line(const struct payload_file *file, size_t *cursor,
+	       const char **line, size_t *line_len)
+{
+	if (*cursor >= file->len)
+		return false;
+
+	const char *start = file->data + *cursor;
+	const char *newline = memchr(start, '\n', file->len - *cursor);
+
+	*line = start;
+
+	if (newline == NULL) {
+		*line_len = file->len - *cursor;
+		*cursor = file->len;
+	} else {
+		*line_len = newline - start;
+		*cursor += *line_len + 1;
+	}
+
+	return true;
+}
+
+bool next_block(const struct payload_file *file, size_t *cursor,
+		const char **block, size_t *block_len)
+{
+	if (*cursor >= file->len)
+		return false;
+
+	const char *start = file->data + *cursor;
+	size_t remaining = file->len - *cursor;
+
+	*block = start;
+	*block_len = remaining;
+
+	if (remaining > PAYLOAD_BLOCK_SIZE) {
+		const char *newline = memrchr(start, '\n', PAYLOAD_BLOCK_SIZE);
+
+		// the first line alone is longer than a block
+		if (newline == NULL)
+			newline = memchr(start + PAYLOAD_BLOCK_SIZE, '\n',
+					 remaining - PAYLOAD_BLOCK_SIZE);
+
+		if (newline != NULL)
+			*block_len = newline - start + 1;
+	}
+
+	*cursor += *block_len;
+
+	return true;
+}
+
+size_t split_payload_file(const struct payload_file *file, size_t parts,
+			  struct payload_file *chunks)
+{
+	size_t count = 0, start = 0;
+
+	for (size_t k = 1; k <= parts && start < file->len; k++) {
+		size_t end = k == parts ? file->len : file->len / parts * k;
+
+		if (end < start)
+			end = start;
+
+		// move the cut behind the next newline
+		if (end < file->len) {
+			const char *newline = memchr(file->data + end, '\n',
+						     file->len - end);
+
+			end = newline ? (size_t) (newline - file->data) + 1 :
+				file->len;
+		}
+
+		chunks[count++] = (struct payload_file) {
+			.data = file->data + start,
+			.len = end - start,
+		};
+		start = end;
+	}
+
+	return count;
+}
+
+size_t count_lines(const struct payload_file *file)
+{
+	const uint64_t ones = 0x0101010101010101, high = ones << 7;
+	const uint64_t low = ~high, newlines = ones * '\n';
+
+	size_t count = 0, i = 0;
+
+	// eight bytes at a time, a byte becomes 0 where it is a newline and
+	// those get a 1 without carries between the bytes; the multiplication
+	// sums the bytes into the top one (a popcount would be a libgcc call
+	// without -mpopcnt)
+	for (; i + 8 <= file->len; i += 8) {
+		uint64_t word;
+		memcpy(&word, file->data + i, sizeof(word));
+		word ^= newlines;
+
+		uint64_t zero = ~(((word & low) + low) | word | low) >> 7;
+		count += zero * ones >> 56;
+	}
+
+	for (; i < file->len; i++)
+		count += file->data[i] == '\n';
+
+	// an unterminated last line
+	if (file->len > 0 && file->data[file->len - 1] != '\n')
+		count++;
+
+	return count;
+}
+
+void unmap_payload_file(struct payload_file *file)
+{
+	if (file->data != NULL)
+		munmap((void *) file->data, file->len);
+
+	file->data = NULL;
+	file->len = 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file payload_file.h
+ * @brief Memory-mapped payload input.
+ *
+ * The whole payload file is mapped read-only and split into lines in place.
+ * Lines are handed out as (pointer, length) spans into the mapping, so there
+ * is neither a line length limit nor a copy through a stdio buffer.
+ */
+
+
+#ifndef PAYLOAD_FILE_H
+#define PAYLOAD_FILE_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/** @brief Preferred size of a block returned by next_block. */
+#define PAYLOAD_BLOCK_SIZE ((size_t) 1 << 20)
+
+
+/**
+ * @brief A read-only mapping of a payload file.
+ */
+struct payload_file {
+	const char *data;  /**< First byte of the mapping, NULL if empty */
+	size_t len;        /**< Size of the file in bytes */
+};
+
+
+/**
+ * @brief Maps the file at path into memory.
+ *
+ * @param file Output for the mapping
+ * @param path Path of the payload file
+ * @return false if the file could not be opened or mapped
+ */
+bool map_payload_file(struct payload_file *file, const char *path);
+
+/**
+ * @brief Yields the next line of the file.
+ *
+ * The returned span points into the mapping and does not include the newline
+ * character. The last line does not need to be terminated by a newline.
+ *
+ * @param file Mapped payload file
+ * @param cursor Offset of the next line, should be 0 for the first call
+ * @param line Output for the first byte of the line
+ * @param line_len Output for the length of the line
+ * @return false if there are no more lines
+ */
+bool next_line(const struct payload_file *file, size_t *cursor,
+	       const char **line, size_t *line_len);
+
+/**
+ * @brief Yields the next block of whole lines.
+ *
+ * Blocks are about PAYLOAD_BLOCK_SIZE bytes long and end right after a
+ * newline (or at the end of the file), so no line is split between blocks.
+ * A single line longer than PAYLOAD_BLOCK_SIZE makes up a block of its own.
+ *
+ * @param file Mapped payload file
+ * @param cursor Offset of the next block, should be 0 for the first call
+ * @param block Output for the first byte of the block
+ * @param block_len Output for the length of the block
+ * @return false if there are no more blocks
+ */
+bool next_block(const struct payload_file *file, size_t *cursor,
+		const char **block, size_t *block_len);
+
+/**
+ * @brief Splits the file into up to parts chunks of whole lines.
+ *
+ * Chunks are about equally long, cover the file in order and end right after
+ * a newline (or at the end of the file). They are views into the mapping and
+ * must not be unmapped themselves.
+ *
+ * @param file Mapped payload file
+ * @param parts Maximum number of chunks
+ * @param chunks Output for the chunks, room for parts entries
+ * @return Number of chunks, fewer than parts for files with few lines
+ */
+size_t split_payload_file(const struct payload_file *file, size_t parts,
+			  struct payload_file *chunks);
+
+/**
+ * @brief Counts the lines of the file, empty ones included.
+ *
+ * An upper bound for the number of payloads, cheap enough to size buffers
+ * with before parsing: one pass over the bytes, eight at a time.
+ */
+size_t count_lines(const struct payload_file *file);
+
+/**
+ * @brief Unmaps the file. Spans obtained from next_line become invalid.
+ */
+void unmap_payload_file(struct payload_file *file);
+
+
+#endif
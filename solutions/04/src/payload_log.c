@@ -0,0 +1,364 @@
+#include "payload_log.h"
+#include "payload.h"
+#include "wire_format.h"
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/* records are written out in batches of about this many bytes */
+#define WRITE_BATCH ((size_t) 1 << 16)
+
+
+/* path of the segment or index starting with base */
+static char *segment_path(const char *dir, uint64_t base, const char *suffix)
+{
+	size_t len = strlen(dir) + 32;
+	char *path = malloc(len);
+	assert(path);
+
+	snprintf(path, len, "%s/%020" PRIu64 "%s", dir, base, suffix);
+	return path;
+}
+
+static int compare_bases(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* first sequence numbers of the segments in dir, ascending */
+static bool list_segments(const char *dir, uint64_t **bases, size_t *count)
+{
+	DIR *d = opendir(dir);
+	if (d == NULL)
+		return false;
+
+	size_t cap = 16;
+	*bases = malloc(cap * sizeof(uint64_t));
+	assert(*bases);
+	*count = 0;
+
+	for (struct dirent *entry; (entry = readdir(d)) != NULL;) {
+		char *end;
+		uint64_t base = strtoull(entry->d_name, &end, 10);
+
+		if (end == entry->d_name || strcmp(end, ".log") != 0)
+			continue;
+
+		if (*count == cap) {
+			cap *= 2;
+			*bases = realloc(*bases, cap * sizeof(uint64_t));
+			assert(*bases);
+		}
+		(*bases)[(*count)++] = base;
+	}
+
+	closedir(d);
+
+	qsort(*bases, *count, sizeof(uint64_t), compare_bases);
+	return true;
+}
+
+/* the index entries of a segment that point into its first len bytes */
+static struct log_index_entry *read_index(const char *dir, uint64_t base,
+					  uint64_t len, size_t *count)
+{
+	char *path = segment_path(dir, base, ".idx");
+	int fd = open(path, O_RDONLY);
+	free(path);
+
+	*count = 0;
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	struct log_index_entry *entries = NULL;
+
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		entries = malloc(st.st_size);
+		assert(entries);
+
+		ssize_t got = read(fd, entries, st.st_size);
+		size_t n = got > 0 ?
+			(size_t) got / sizeof(struct log_index_entry) : 0;
+
+		// a crash may leave entries for records that never made it
+		while (*count < n && entries[*count].offset < len &&
+		       entries[*count].seq >= base)
+			(*count)++;
+	}
+
+	close(fd);
+	return entries;
+}
+
+/* scans a segment from the record with sequence number from on, appending
+ * its payloads to buf unless it is NULL; returns the sequence number past
+ * the last complete record */
+static uint64_t scan_segment(const char *dir, uint64_t base, uint64_t from,
+			     struct payload_buffer *buf)
+{
+	char *path = segment_path(dir, base, ".log");
+	int fd = open(path, O_RDONLY);
+	free(path);
+
+	if (fd < 0)
+		return base;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size == 0) {
+		close(fd);
+		return base;
+	}
+
+	uint64_t len = st.st_size;
+	const char *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return base;
+
+	// start at the last indexed record not past from
+	size_t count;
+	struct log_index_entry *index = read_index(dir, base, len, &count);
+	uint64_t seq = base, offset = 0;
+	size_t lo = 0, hi = count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (index[mid].seq <= from)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo > 0) {
+		seq = index[lo - 1].seq;
+		offset = index[lo - 1].offset;
+	}
+	free(index);
+
+	madvise((void *) data, len, MADV_SEQUENTIAL);
+
+	// records before from are only stepped over
+	while (!buf || seq < from) {
+		uint32_t record_len;
+
+		if (len - offset < sizeof(record_len))
+			break;
+		memcpy(&record_len, data + offset, sizeof(record_len));
+
+		if (len - offset - sizeof(record_len) < record_len)
+			break;
+
+		offset += sizeof(record_len) + record_len;
+		seq++;
+	}
+
+	// the rest of the segment is decoded as one run, up to a torn or
+	// invalid record
+	if (buf) {
+		size_t used;
+		seq += deserialize_payload_run(buf, data + offset, len - offset,
+					       &used);
+	}
+
+	munmap((void *) data, len);
+
+	return seq;
+}
+
+bool open_payload_log(struct payload_log *log, const char *dir,
+		      size_t segment_bytes)
+{
+	if (mkdir(dir, 0777) < 0 && errno != EEXIST)
+		return false;
+
+	uint64_t *bases;
+	size_t count;
+
+	if (!list_segments(dir, &bases, &count))
+		return false;
+
+	*log = (struct payload_log) {
+		.dir = strdup(dir),
+		.segment_bytes = segment_bytes ? segment_bytes :
+			LOG_DEFAULT_SEGMENT_BYTES,
+		.segment_fd = -1,
+		.index_fd = -1,
+	};
+	assert(log->dir);
+
+	// continue after the last complete record
+	if (count > 0)
+		log->next_seq = scan_segment(dir, bases[count - 1], UINT64_MAX,
+					     NULL);
+
+	free(bases);
+	return true;
+}
+
+static void write_all(int fd, const void *data, size_t len)
+{
+	while (len > 0) {
+		ssize_t written = write(fd, data, len);
+		assert(written > 0);
+
+		data = (const char *) data + written;
+		len -= written;
+	}
+}
+
+void flush_payload_log(struct payload_log *log)
+{
+	if (log->segment_fd < 0)
+		return;
+
+	// records before the entries pointing at them
+	write_all(log->segment_fd, log->pending, log->pending_len);
+	write_all(log->index_fd, log->pending_index,
+		  log->pending_index_len * sizeof(struct log_index_entry));
+
+	log->pending_len = 0;
+	log->pending_index_len = 0;
+}
+
+static void close_segment(struct payload_log *log)
+{
+	if (log->segment_fd < 0)
+		return;
+
+	flush_payload_log(log);
+
+	close(log->segment_fd);
+	close(log->index_fd);
+	log->segment_fd = log->index_fd = -1;
+}
+
+static void open_segment(struct payload_log *log)
+{
+	log->segment_base = log->next_seq;
+	log->segment_len = 0;
+	log->next_indexed = 0;
+
+	char *path = segment_path(log->dir, log->segment_base, ".log");
+	log->segment_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	assert(log->segment_fd >= 0);
+	free(path);
+
+	path = segment_path(log->dir, log->segment_base, ".idx");
+	log->index_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	assert(log->index_fd >= 0);
+	free(path);
+}
+
+void log_payload(struct payload_log *log, const struct payload *p)
+{
+	// the record is encoded behind its length, which is filled in after
+	size_t at = log->pending_len;
+	uint32_t record_len;
+	size_t len = at + sizeof(record_len);
+
+	if (len > log->pending_cap) {
+		log->pending_cap = WRITE_BATCH * 2;
+		log->pending = realloc(log->pending, log->pending_cap);
+		assert(log->pending);
+	}
+
+	serialize_payloads_append(p, 1, &log->pending, &len,
+				  &log->pending_cap);
+
+	assert(len - at - sizeof(record_len) <= UINT32_MAX);
+	record_len = len - at - sizeof(record_len);
+	memcpy(log->pending + at, &record_len, sizeof(record_len));
+
+	size_t size = len - at;
+
+	// an oversized record still gets a segment of its own; everything
+	// before the record goes to the old segment
+	if (log->segment_fd < 0 ||
+	    (log->segment_len > 0 &&
+	     log->segment_len + size > log->segment_bytes)) {
+		log->pending_len = at;
+		close_segment(log);
+		open_segment(log);
+
+		memmove(log->pending, log->pending + at, size);
+		at = 0;
+	}
+
+	if (log->segment_len >= log->next_indexed) {
+		if (log->pending_index_len == log->pending_index_cap) {
+			log->pending_index_cap = log->pending_index_cap ?
+				log->pending_index_cap * 2 : 64;
+			log->pending_index = realloc(log->pending_index,
+				log->pending_index_cap *
+				sizeof(struct log_index_entry));
+			assert(log->pending_index);
+		}
+
+		log->pending_index[log->pending_index_len++] =
+			(struct log_index_entry) {
+				.seq = log->next_seq,
+				.offset = log->segment_len,
+			};
+		log->next_indexed = log->segment_len + LOG_INDEX_INTERVAL;
+	}
+
+	log->pending_len = at + size;
+	log->segment_len += size;
+	log->next_seq++;
+
+	if (log->pending_len >= WRITE_BATCH)
+		flush_payload_log(log);
+}
+
+void close_payload_log(struct payload_log *log)
+{
+	close_segment(log);
+
+	free(log->pending);
+	free(log->pending_index);
+	free(log->dir);
+	*log = (struct payload_log) { .segment_fd = -1, .index_fd = -1 };
+}
+
+bool replay_payload_log(struct payload_buffer *buf, const char *dir,
+			uint64_t from)
+{
+	uint64_t *bases;
+	size_t count;
+
+	if (!list_segments(dir, &bases, &count))
+		return false;
+
+	// the last segment starting at or before from holds it
+	size_t lo = 0, hi = count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (bases[mid] <= from)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (size_t i = lo > 0 ? lo - 1 : 0; i < count; i++)
+		scan_segment(dir, bases[i], from, buf);
+
+	free(bases);
+	return true;
+}
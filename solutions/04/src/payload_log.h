@@ -0,0 +1,108 @@
+/**
+ * @file payload_log.h
+ * @brief Append-only on-disk log of payloads, for replaying traffic.
+ *
+ * Every payload appended gets the next sequence number and is stored in the
+ * wire format, prefixed with its length as a native u32. Records go to the
+ * segment files of a directory, named after the sequence number of their
+ * first record, and a new segment is started once the current one would
+ * outgrow its size limit. Next to each segment, a sparse index holds the
+ * sequence number and offset of one record roughly every LOG_INDEX_INTERVAL
+ * bytes, so replay finds where to start with two binary searches and a
+ * short scan, and then reads the segments through mmap.
+ *
+ * Records are buffered and written out when the buffer fills, on a segment
+ * switch and on flush or close; nothing is synced to the disk. A record torn
+ * by a crash ends its segment on replay.
+ */
+
+
+#ifndef PAYLOAD_LOG_H
+#define PAYLOAD_LOG_H
+
+
+#include "dynamic_dispatch.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Bytes of records between two entries of a segment index */
+#define LOG_INDEX_INTERVAL 4096
+
+/* Size limit of a segment when none is given */
+#define LOG_DEFAULT_SEGMENT_BYTES ((size_t) 64 << 20)
+
+
+struct payload;
+
+/**
+ * @brief Sequence number and offset of a record in its segment.
+ */
+struct log_index_entry {
+	uint64_t seq;
+	uint64_t offset;
+};
+
+/**
+ * @brief Writing end of a log.
+ */
+struct payload_log {
+	char *dir;
+	size_t segment_bytes;     /**< Size limit of a segment */
+	uint64_t next_seq;        /**< Sequence number of the next record */
+
+	uint64_t segment_base;    /**< First sequence number of the segment */
+	int segment_fd;           /**< Open segment, -1 before the first */
+	int index_fd;
+	uint64_t segment_len;     /**< Bytes of the segment, buffered too */
+	uint64_t next_indexed;    /**< Records from here on get an entry */
+
+	char *pending;            /**< Records not written yet */
+	size_t pending_len;
+	size_t pending_cap;
+	struct log_index_entry *pending_index;
+	size_t pending_index_len;
+	size_t pending_index_cap;
+};
+
+
+/**
+ * @brief Opens the log in dir, creating the directory if needed.
+ *
+ * Records of an existing log are kept, appending continues with the next
+ * sequence number in a new segment.
+ *
+ * @param segment_bytes Size limit of a segment, 0 for the default
+ * @return False if the directory cannot be created or read
+ */
+bool open_payload_log(struct payload_log *log, const char *dir,
+		      size_t segment_bytes);
+
+/**
+ * @brief Appends a payload, giving it the next sequence number.
+ */
+void log_payload(struct payload_log *log, const struct payload *p);
+
+/**
+ * @brief Writes out the buffered records and index entries.
+ */
+void flush_payload_log(struct payload_log *log);
+
+/**
+ * @brief Flushes and closes the log.
+ */
+void close_payload_log(struct payload_log *log);
+
+/**
+ * @brief Appends the payloads of the log in dir to buf, starting with
+ * sequence number from.
+ *
+ * @return False if the directory cannot be read
+ */
+bool replay_payload_log(struct payload_buffer *buf, const char *dir,
+			uint64_t from);
+
+
+#endif
@@ -0,0 +1,63 @@
+#include "pipeline.h"
+#include "dynamic_dispatch.h"
+#include "spsc_ring.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+
+
+struct reader {
+	const struct payload_file *file;
+	struct spsc_ring *ring;
+};
+
+
+static void *read_blocks(void *arg)
+{
+	struct reader *reader = arg;
+
+	const char *block;
+	size_t block_len, cursor = 0;
+
+	while (next_block(reader->file, &cursor, &block, &block_len)) {
+		struct payload_buffer *buf = new_buffer();
+
+		push_payloads_bulk(buf, block, block_len);
+
+		spsc_push_wait(reader->ring, buf);
+	}
+
+	// end of input
+	spsc_push_wait(reader->ring, NULL);
+
+	return NULL;
+}
+
+long process_pipelined(const struct payload_file *file, size_t depth)
+{
+	struct spsc_ring ring;
+	spsc_init(&ring, depth);
+
+	struct reader reader = { .file = file, .ring = &ring };
+	pthread_t thread;
+	[[maybe_unused]] int created =
+		pthread_create(&thread, NULL, read_blocks, &reader);
+	assert(created == 0);
+
+	long processed = 0;
+	struct payload_buffer *buf;
+
+	while ((buf = spsc_pop_wait(&ring)) != NULL) {
+		while (buf->process_base < buf->len)
+			process_next(buf);
+
+		processed += buf->len;
+		destroy(buf);
+	}
+
+	pthread_join(thread, NULL);
+	spsc_free(&ring);
+
+	return processed;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file pipeline.h
+ * @brief Parsing and processing a payload file at the same time.
+ */
+
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+
+#include "payload_file.h"
+
+
+/** @brief Parsed blocks that may wait for the processor by default. */
+#define PIPELINE_DEFAULT_DEPTH 8
+
+
+/**
+ * @brief Processes every payload of file while it is still being parsed.
+ *
+ * A reader thread parses the file block by block, each block into a
+ * payload_buffer of its own, and hands the buffers over through a lock-free
+ * single-producer/single-consumer ring. The calling thread processes and
+ * destroys them in order. The ring holds at most depth buffers, so memory
+ * stays proportional to depth blocks no matter how large the file is.
+ *
+ * @param file Mapped payload file
+ * @param depth Capacity of the ring, in blocks
+ * @return Number of payloads processed
+ */
+long process_pipelined(const struct payload_file *file, size_t depth);
+
+
+#endif
@@ -0,0 +1,474 @@
+#include "roaring.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define BITMAP_WORDS (65536 / 64)
+
+
+/* index of the container with key, or where to insert it */
+static uint32_t find_container(const struct roaring *r, uint16_t key,
+			       bool *found)
+{
+	uint32_t lo = 0, hi = r->len;
+
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+
+		if (r->containers[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	*found = lo < r->len && r->containers[lo].key == key;
+	return lo;
+}
+
+/* index of the first value not below low in a sorted array */
+static uint32_t lower_bound(const uint16_t *array, uint32_t len, uint16_t low)
+{
+	uint32_t lo = 0, hi = len;
+
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+
+		if (array[mid] < low)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static void reserve_containers(struct roaring *r, uint32_t len)
+{
+	if (len <= r->cap)
+		return;
+
+	r->cap = r->cap ? r->cap * 2 : 4;
+	if (r->cap < len)
+		r->cap = len;
+
+	r->containers = realloc(r->containers,
+				r->cap * sizeof(struct roaring_container));
+	assert(r->containers);
+}
+
+/* inserts an empty array container with key at index i */
+static struct roaring_container *insert_container(struct roaring *r,
+						  uint32_t i, uint16_t key)
+{
+	reserve_containers(r, r->len + 1);
+
+	memmove(&r->containers[i + 1], &r->containers[i],
+		(r->len - i) * sizeof(struct roaring_container));
+	r->len++;
+
+	r->containers[i] = (struct roaring_container) { .key = key };
+	return &r->containers[i];
+}
+
+static void free_container(struct roaring_container *c)
+{
+	if (c->is_bitmap)
+		free(c->bits);
+	else
+		free(c->array);
+}
+
+static void remove_container(struct roaring *r, uint32_t i)
+{
+	free_container(&r->containers[i]);
+
+	memmove(&r->containers[i], &r->containers[i + 1],
+		(r->len - i - 1) * sizeof(struct roaring_container));
+	r->len--;
+}
+
+static void to_bitmap(struct roaring_container *c)
+{
+	uint64_t *bits = calloc(BITMAP_WORDS, sizeof(uint64_t));
+	assert(bits);
+
+	for (uint32_t i = 0; i < c->cardinality; i++)
+		bits[c->array[i] >> 6] |= 1ull << (c->array[i] & 63);
+
+	free(c->array);
+	c->bits = bits;
+	c->is_bitmap = true;
+	c->cap = 0;
+}
+
+static void to_array(struct roaring_container *c)
+{
+	uint16_t *array = malloc(c->cardinality * sizeof(uint16_t));
+	assert(array || c->cardinality == 0);
+
+	uint32_t n = 0;
+
+	for (uint32_t w = 0; w < BITMAP_WORDS; w++)
+		for (uint64_t word = c->bits[w]; word; word &= word - 1)
+			array[n++] = w * 64 + __builtin_ctzll(word);
+
+	free(c->bits);
+	c->array = array;
+	c->is_bitmap = false;
+	c->cap = c->cardinality;
+}
+
+bool roaring_add(struct roaring *r, uint32_t x)
+{
+	uint16_t key = x >> 16, low = x & 0xffff;
+	bool found;
+	uint32_t i = find_container(r, key, &found);
+
+	struct roaring_container *c = found ?
+		&r->containers[i] : insert_container(r, i, key);
+
+	if (!c->is_bitmap) {
+		uint32_t pos = lower_bound(c->array, c->cardinality, low);
+
+		if (pos < c->cardinality && c->array[pos] == low)
+			return false;
+
+		if (c->cardinality < ROARING_ARRAY_MAX) {
+			if (c->cardinality == c->cap) {
+				c->cap = c->cap ? c->cap * 2 : 4;
+				if (c->cap > ROARING_ARRAY_MAX)
+					c->cap = ROARING_ARRAY_MAX;
+
+				c->array = realloc(c->array,
+						   c->cap * sizeof(uint16_t));
+				assert(c->array);
+			}
+
+			memmove(&c->array[pos + 1], &c->array[pos],
+				(c->cardinality - pos) * sizeof(uint16_t));
+			c->array[pos] = low;
+			c->cardinality++;
+			return true;
+		}
+
+		to_bitmap(c);
+	}
+
+	uint64_t bit = 1ull << (low & 63);
+
+	if (c->bits[low >> 6] & bit)
+		return false;
+
+	c->bits[low >> 6] |= bit;
+	c->cardinality++;
+	return true;
+}
+
+bool roaring_remove(struct roaring *r, uint32_t x)
+{
+	uint16_t key = x >> 16, low = x & 0xffff;
+	bool found;
+	uint32_t i = find_container(r, key, &found);
+
+	if (!found)
+		return false;
+
+	struct roaring_container *c = &r->containers[i];
+
+	if (c->is_bitmap) {
+		uint64_t bit = 1ull << (low & 63);
+
+		if (!(c->bits[low >> 6] & bit))
+			return false;
+
+		c->bits[low >> 6] &= ~bit;
+
+		if (--c->cardinality < ROARING_ARRAY_MIN)
+			to_array(c);
+		return true;
+	}
+
+	uint32_t pos = lower_bound(c->array, c->cardinality, low);
+
+	if (pos == c->cardinality || c->array[pos] != low)
+		return false;
+
+	memmove(&c->array[pos], &c->array[pos + 1],
+		(c->cardinality - pos - 1) * sizeof(uint16_t));
+
+	if (--c->cardinality == 0)
+		remove_container(r, i);
+	return true;
+}
+
+bool roaring_contains(const struct roaring *r, uint32_t x)
+{
+	uint16_t key = x >> 16, low = x & 0xffff;
+	bool found;
+	uint32_t i = find_container(r, key, &found);
+
+	if (!found)
+		return false;
+
+	const struct roaring_container *c = &r->containers[i];
+
+	if (c->is_bitmap)
+		return c->bits[low >> 6] >> (low & 63) & 1;
+
+	uint32_t pos = lower_bound(c->array, c->cardinality, low);
+	return pos < c->cardinality && c->array[pos] == low;
+}
+
+uint64_t roaring_cardinality(const struct roaring *r)
+{
+	uint64_t n = 0;
+
+	for (uint32_t i = 0; i < r->len; i++)
+		n += r->containers[i].cardinality;
+
+	return n;
+}
+
+size_t roaring_bytes(const struct roaring *r)
+{
+	size_t bytes = r->cap * sizeof(struct roaring_container);
+
+	for (uint32_t i = 0; i < r->len; i++)
+		bytes += r->containers[i].is_bitmap ?
+			BITMAP_WORDS * sizeof(uint64_t) :
+			r->containers[i].cap * sizeof(uint16_t);
+
+	return bytes;
+}
+
+bool roaring_next(const struct roaring *r, struct roaring_cursor *c,
+		  uint32_t *x)
+{
+	for (; c->container < r->len; c->container++, c->offset = 0) {
+		const struct roaring_container *cont = \
+			&r->containers[c->container];
+		uint32_t high = (uint32_t) cont->key << 16;
+
+		if (!cont->is_bitmap) {
+			if (c->offset < cont->cardinality) {
+				*x = high | cont->array[c->offset++];
+				return true;
+			}
+			continue;
+		}
+
+		// offset is the next bit to look at
+		for (uint32_t w = c->offset >> 6; w < BITMAP_WORDS; w++) {
+			uint64_t word = cont->bits[w];
+
+			if (w == c->offset >> 6)
+				word &= ~0ull << (c->offset & 63);
+
+			if (word) {
+				uint32_t low = w * 64 + __builtin_ctzll(word);
+
+				c->offset = low + 1;
+				*x = high | low;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/* lower bits in both arrays, written to out unless it is NULL */
+static uint32_t and_arrays(const struct roaring_container *a,
+			   const struct roaring_container *b, uint16_t *out)
+{
+	if (a->cardinality > b->cardinality) {
+		const struct roaring_container *t = a;
+		a = b;
+		b = t;
+	}
+
+	uint32_t n = 0;
+
+	// much smaller sets search the larger one instead of merging
+	if ((uint64_t) a->cardinality * 32 < b->cardinality) {
+		uint32_t from = 0;
+
+		for (uint32_t i = 0; i < a->cardinality; i++) {
+			from += lower_bound(b->array + from,
+					    b->cardinality - from,
+					    a->array[i]);
+
+			if (from == b->cardinality)
+				break;
+			if (b->array[from] == a->array[i]) {
+				if (out)
+					out[n] = a->array[i];
+				n++;
+			}
+		}
+
+		return n;
+	}
+
+	for (uint32_t i = 0, j = 0; i < a->cardinality && j < b->cardinality;) {
+		if (a->array[i] < b->array[j]) {
+			i++;
+		} else if (a->array[i] > b->array[j]) {
+			j++;
+		} else {
+			if (out)
+				out[n] = a->array[i];
+			n++;
+			i++;
+			j++;
+		}
+	}
+
+	return n;
+}
+
+/* lower bits of the array that are set in the bitmap */
+static uint32_t and_array_bitmap(const struct roaring_container *a,
+				 const struct roaring_container *b,
+				 uint16_t *out)
+{
+	uint32_t n = 0;
+
+	for (uint32_t i = 0; i < a->cardinality; i++) {
+		uint16_t low = a->array[i];
+
+		if (b->bits[low >> 6] >> (low & 63) & 1) {
+			if (out)
+				out[n] = low;
+			n++;
+		}
+	}
+
+	return n;
+}
+
+static uint32_t and_bitmaps(const struct roaring_container *a,
+			    const struct roaring_container *b, uint64_t *out)
+{
+	uint32_t n = 0;
+
+	for (uint32_t w = 0; w < BITMAP_WORDS; w++) {
+		uint64_t word = a->bits[w] & b->bits[w];
+
+		if (out)
+			out[w] = word;
+		n += __builtin_popcountll(word);
+	}
+
+	return n;
+}
+
+/* intersection of two containers with the same key, empty or not */
+static struct roaring_container and_containers(
+	const struct roaring_container *a, const struct roaring_container *b)
+{
+	struct roaring_container c = { .key = a->key };
+
+	if (a->is_bitmap && b->is_bitmap) {
+		c.bits = malloc(BITMAP_WORDS * sizeof(uint64_t));
+		assert(c.bits);
+		c.is_bitmap = true;
+		c.cardinality = and_bitmaps(a, b, c.bits);
+
+		if (c.cardinality <= ROARING_ARRAY_MAX)
+			to_array(&c);
+		return c;
+	}
+
+	if (a->is_bitmap) {
+		const struct roaring_container *t = a;
+		a = b;
+		b = t;
+	}
+
+	// at most as many as the smaller side
+	uint32_t cap = a->cardinality;
+	if (!b->is_bitmap && b->cardinality < cap)
+		cap = b->cardinality;
+
+	c.array = malloc(cap * sizeof(uint16_t));
+	assert(c.array || cap == 0);
+	c.cap = cap;
+	c.cardinality = b->is_bitmap ?
+		and_array_bitmap(a, b, c.array) : and_arrays(a, b, c.array);
+
+	return c;
+}
+
+void roaring_and(struct roaring *dst, const struct roaring *a,
+		 const struct roaring *b)
+{
+	assert(dst != a && dst != b);
+
+	roaring_free(dst);
+
+	for (uint32_t i = 0, j = 0; i < a->len && j < b->len;) {
+		const struct roaring_container *ca = &a->containers[i];
+		const struct roaring_container *cb = &b->containers[j];
+
+		if (ca->key < cb->key) {
+			i++;
+		} else if (ca->key > cb->key) {
+			j++;
+		} else {
+			struct roaring_container c = and_containers(ca, cb);
+
+			if (c.cardinality > 0) {
+				reserve_containers(dst, dst->len + 1);
+				dst->containers[dst->len++] = c;
+			} else {
+				free_container(&c);
+			}
+
+			i++;
+			j++;
+		}
+	}
+}
+
+uint64_t roaring_and_cardinality(const struct roaring *a,
+				 const struct roaring *b)
+{
+	uint64_t n = 0;
+
+	for (uint32_t i = 0, j = 0; i < a->len && j < b->len;) {
+		const struct roaring_container *ca = &a->containers[i];
+		const struct roaring_container *cb = &b->containers[j];
+
+		if (ca->key < cb->key) {
+			i++;
+		} else if (ca->key > cb->key) {
+			j++;
+		} else {
+			if (ca->is_bitmap && cb->is_bitmap)
+				n += and_bitmaps(ca, cb, NULL);
+			else if (ca->is_bitmap)
+				n += and_array_bitmap(cb, ca, NULL);
+			else if (cb->is_bitmap)
+				n += and_array_bitmap(ca, cb, NULL);
+			else
+				n += and_arrays(ca, cb, NULL);
+
+			i++;
+			j++;
+		}
+	}
+
+	return n;
+}
+
+void roaring_free(struct roaring *r)
+{
+	for (uint32_t i = 0; i < r->len; i++)
+		free_container(&r->containers[i]);
+
+	free(r->containers);
+	*r = (struct roaring) { .containers = NULL };
+}
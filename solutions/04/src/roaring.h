@@ -0,0 +1,118 @@
+/**
+ * @file roaring.h
+ * @brief Compressed bitmaps over 32-bit IDs, in the style of Roaring.
+ *
+ * The ID space is cut into chunks of 2^16 IDs keyed by the upper 16 bits.
+ * Each chunk holding at least one ID gets a container: a sorted array of the
+ * lower 16 bits while it holds at most ROARING_ARRAY_MAX IDs, a plain 8 KiB
+ * bitmap once it holds more, and an array again below ROARING_ARRAY_MIN.
+ * Sparse sets cost 2 bytes per ID, dense ones at most 1 bit, and both iterate
+ * and intersect word by word or by merging.
+ */
+
+
+#ifndef ROARING_H
+#define ROARING_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Containers switch to a bitmap above this many IDs, where both take 8 KiB */
+#define ROARING_ARRAY_MAX 4096
+
+/* Bitmaps switch back below this many, so that adding and removing around
+ * ROARING_ARRAY_MAX does not convert on every call */
+#define ROARING_ARRAY_MIN (ROARING_ARRAY_MAX / 4 * 3)
+
+
+struct roaring_container {
+	uint16_t key;          /**< Upper 16 bits of every ID inside */
+	bool is_bitmap;
+	uint32_t cardinality;
+	uint32_t cap;          /**< Capacity of the array, unused for bitmaps */
+	union {
+		uint16_t *array;  /**< Sorted lower 16 bits */
+		uint64_t *bits;   /**< 1024 words of bits */
+	};
+};
+
+/**
+ * @brief Set of 32-bit IDs. Zero-initialize before first use.
+ */
+struct roaring {
+	struct roaring_container *containers;  /**< Sorted by key */
+	uint32_t len;
+	uint32_t cap;
+};
+
+/**
+ * @brief Position of an iteration, zero-initialize to start at the
+ * smallest ID.
+ */
+struct roaring_cursor {
+	uint32_t container;
+	uint32_t offset;  /**< Array index or bit position in the container */
+};
+
+
+/**
+ * @brief Adds x to the set.
+ *
+ * @return Whether x was not in the set before
+ */
+bool roaring_add(struct roaring *r, uint32_t x);
+
+/**
+ * @brief Removes x from the set.
+ *
+ * @return Whether x was in the set before
+ */
+bool roaring_remove(struct roaring *r, uint32_t x);
+
+bool roaring_contains(const struct roaring *r, uint32_t x);
+
+/**
+ * @brief Number of IDs in the set.
+ */
+uint64_t roaring_cardinality(const struct roaring *r);
+
+/**
+ * @brief Bytes of heap memory the set occupies.
+ */
+size_t roaring_bytes(const struct roaring *r);
+
+/**
+ * @brief Moves the cursor to the next ID of the set in ascending order.
+ *
+ * The set must not change during an iteration.
+ *
+ * @param x Output for the ID
+ * @return False once every ID has been visited
+ */
+bool roaring_next(const struct roaring *r, struct roaring_cursor *c,
+		  uint32_t *x);
+
+/**
+ * @brief Replaces dst with the IDs in both a and b.
+ *
+ * dst must be initialized and may be neither a nor b.
+ */
+void roaring_and(struct roaring *dst, const struct roaring *a,
+		 const struct roaring *b);
+
+/**
+ * @brief Number of IDs in both a and b, without building the intersection.
+ */
+uint64_t roaring_and_cardinality(const struct roaring *a,
+				 const struct roaring *b);
+
+/**
+ * @brief Frees the containers, leaving an empty set.
+ */
+void roaring_free(struct roaring *r);
+
+
+#endif
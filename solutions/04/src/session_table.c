@@ -0,0 +1,222 @@
+#include "session_table.h"
+#include "intern.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+
+#define SHARD_BITS 6
+#define SHARDS (1 << SHARD_BITS)
+
+/* slots of a shard when its first session opens */
+#define MIN_SLOTS 16
+
+
+struct session_slot {
+	uint32_t key;       /**< Interned ID + 1, 0 for a free slot */
+	uint32_t sessions;  /**< Open sessions of the user */
+};
+
+struct shard {
+	pthread_mutex_t lock;
+	struct session_slot *slots;
+	uint32_t mask;
+	uint32_t count;
+};
+
+
+static struct shard shards[SHARDS];
+static pthread_once_t shards_once = PTHREAD_ONCE_INIT;
+
+
+static void init_shards()
+{
+	for (int i = 0; i < SHARDS; i++)
+		pthread_mutex_init(&shards[i].lock, NULL);
+}
+
+/* the multiplier is odd, so dense IDs spread over the low bits without
+ * colliding; the high bits pick the shard */
+static uint32_t hash(uint32_t key)
+{
+	return key * 2654435761u;
+}
+
+static struct shard *shard_of(uint32_t key)
+{
+	pthread_once(&shards_once, init_shards);
+
+	return &shards[hash(key) >> (32 - SHARD_BITS)];
+}
+
+/* slot holding key, or the free slot ending its probe sequence */
+static uint32_t probe(const struct shard *shard, uint32_t key)
+{
+	uint32_t i = hash(key) & shard->mask;
+
+	while (shard->slots[i].key != 0 && shard->slots[i].key != key)
+		i = (i + 1) & shard->mask;
+
+	return i;
+}
+
+/* resizes the table of a shard, called with its lock held */
+static void resize(struct shard *shard, uint32_t cap)
+{
+	struct session_slot *old = shard->slots;
+	uint32_t old_cap = old ? shard->mask + 1 : 0;
+
+	shard->slots = calloc(cap, sizeof(struct session_slot));
+	assert(shard->slots);
+	shard->mask = cap - 1;
+
+	for (uint32_t i = 0; i < old_cap; i++)
+		if (old[i].key != 0)
+			shard->slots[probe(shard, old[i].key)] = old[i];
+
+	free(old);
+}
+
+/* empties slot i, moving back later slots of its cluster that probed past
+ * it so that no lookup stops short of them */
+static void remove_slot(struct shard *shard, uint32_t i)
+{
+	for (uint32_t j = i;;) {
+		j = (j + 1) & shard->mask;
+
+		uint32_t key = shard->slots[j].key;
+		if (key == 0)
+			break;
+
+		// distance from the home slot, compared modulo the size
+		uint32_t home = hash(key) & shard->mask;
+		if (((j - home) & shard->mask) >= ((j - i) & shard->mask)) {
+			shard->slots[i] = shard->slots[j];
+			i = j;
+		}
+	}
+
+	shard->slots[i] = (struct session_slot) { .key = 0 };
+}
+
+void open_session(const char *user)
+{
+	uint32_t key = interned_id(user) + 1;
+	assert(key != 0);
+
+	struct shard *shard = shard_of(key);
+	pthread_mutex_lock(&shard->lock);
+
+	if (shard->slots == NULL)
+		resize(shard, MIN_SLOTS);
+
+	struct session_slot *slot = &shard->slots[probe(shard, key)];
+
+	if (slot->key == 0) {
+		*slot = (struct session_slot) { .key = key };
+
+		// keep the load factor at most 3/4
+		if (++shard->count * 4 > (shard->mask + 1) * 3) {
+			resize(shard, (shard->mask + 1) * 2);
+			slot = &shard->slots[probe(shard, key)];
+		}
+	}
+
+	slot->sessions++;
+
+	pthread_mutex_unlock(&shard->lock);
+}
+
+bool close_session(const char *user)
+{
+	uint32_t key = interned_id(user) + 1;
+	struct shard *shard = shard_of(key);
+	bool closed = false;
+
+	pthread_mutex_lock(&shard->lock);
+
+	if (shard->slots) {
+		uint32_t i = probe(shard, key);
+
+		if (shard->slots[i].key == key) {
+			closed = true;
+
+			if (--shard->slots[i].sessions == 0) {
+				remove_slot(shard, i);
+				shard->count--;
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&shard->lock);
+
+	return closed;
+}
+
+bool is_online(const char *user)
+{
+	uint32_t key = interned_id(user) + 1;
+	struct shard *shard = shard_of(key);
+
+	pthread_mutex_lock(&shard->lock);
+
+	bool online = shard->slots &&
+		shard->slots[probe(shard, key)].key == key;
+
+	pthread_mutex_unlock(&shard->lock);
+
+	return online;
+}
+
+size_t online_count(void)
+{
+	size_t count = 0;
+
+	pthread_once(&shards_once, init_shards);
+
+	for (int i = 0; i < SHARDS; i++) {
+		struct shard *shard = &shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		count += shard->count;
+		pthread_mutex_unlock(&shard->lock);
+	}
+
+	return count;
+}
+
+size_t session_table_bytes(void)
+{
+	size_t bytes = 0;
+
+	pthread_once(&shards_once, init_shards);
+
+	for (int i = 0; i < SHARDS; i++) {
+		struct shard *shard = &shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		if (shard->slots)
+			bytes += (shard->mask + 1) *
+				sizeof(struct session_slot);
+		pthread_mutex_unlock(&shard->lock);
+	}
+
+	return bytes;
+}
+
+void clear_session_table(void)
+{
+	pthread_once(&shards_once, init_shards);
+
+	for (int i = 0; i < SHARDS; i++) {
+		struct shard *shard = &shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		free(shard->slots);
+		shard->slots = NULL;
+		shard->mask = 0;
+		shard->count = 0;
+		pthread_mutex_unlock(&shard->lock);
+	}
+}
@@ -0,0 +1,59 @@
+/**
+ * @file session_table.h
+ * @brief Users with an open session, shared by all threads.
+ *
+ * Users are identified by their interned names, whose dense IDs are the
+ * keys of an open-addressing table of flat 8-byte slots with linear probing.
+ * Removal shifts the following slots back instead of leaving tombstones, so
+ * login and logout churn never degrades probing. The table is sharded by
+ * hash, each shard behind a lock of its own. A shard doubles once it is 3/4
+ * full and never shrinks, so at the peak it takes 11 to 22 bytes per user
+ * online.
+ */
+
+
+#ifndef SESSION_TABLE_H
+#define SESSION_TABLE_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief Opens a session of user, who may already have others.
+ *
+ * @param user Interned user name
+ */
+void open_session(const char *user);
+
+/**
+ * @brief Closes one session of user.
+ *
+ * @return Whether user had a session to close
+ */
+bool close_session(const char *user);
+
+/**
+ * @brief Whether user has at least one open session.
+ */
+bool is_online(const char *user);
+
+/**
+ * @brief Number of users with at least one open session.
+ */
+size_t online_count(void);
+
+/**
+ * @brief Bytes of heap memory the table occupies.
+ */
+size_t session_table_bytes(void);
+
+/**
+ * @brief Closes every session and frees the table.
+ */
+void clear_session_table(void);
+
+
+#endif
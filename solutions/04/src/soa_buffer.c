@@ -0,0 +1,119 @@
+#include "soa_buffer.h"
+#include "payload.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+struct soa_payload_buffer *soa_new_buffer()
+{
+	struct soa_payload_buffer *buf = malloc(
+		sizeof(struct soa_payload_buffer));
+	assert(buf);
+
+	*buf = (struct soa_payload_buffer) {
+		.vtables = malloc(sizeof(struct payload_vtable *)),
+		.cap = 1,
+		.strings = { .chunks = NULL },
+	};
+	assert(buf->vtables);
+
+	return buf;
+}
+
+/* only a handful of vtables exist, so columns are searched linearly */
+static struct soa_column *find_column(struct soa_payload_buffer *buf,
+				      const struct payload_vtable *vtable)
+{
+	for (int i = 0; i < buf->column_count; i++)
+		if (buf->columns[i].vtable == vtable)
+			return &buf->columns[i];
+
+	buf->columns = realloc(buf->columns, (buf->column_count + 1) *
+			       sizeof(struct soa_column));
+	assert(buf->columns);
+
+	struct soa_column *column = &buf->columns[buf->column_count++];
+	*column = (struct soa_column) { .vtable = vtable };
+
+	return column;
+}
+
+void soa_push_payload(struct soa_payload_buffer *buf,
+		      const struct payload_line *line)
+{
+	struct payload parsed;
+
+	if (!parse_payload(&parsed, line, &buf->strings))
+		return;
+
+	if (buf->cap == buf->len) {
+		buf->cap *= 2;
+		buf->vtables = realloc(buf->vtables, buf->cap *
+				       sizeof(struct payload_vtable *));
+		assert(buf->vtables);
+	}
+
+	buf->vtables[buf->len++] = parsed.vtable;
+
+	struct soa_column *column = find_column(buf, parsed.vtable);
+	size_t size = parsed.vtable->data_size;
+
+	// payloads without data only take up their vtable pointer
+	if (size == 0)
+		return;
+
+	if (column->cap == column->len) {
+		column->cap = column->cap ? column->cap * 2 : 1;
+		column->rows = realloc(column->rows, column->cap * size);
+		assert(column->rows);
+	}
+
+	memcpy(column->rows + column->len++ * size, &parsed.data, size);
+}
+
+void soa_process_next(struct soa_payload_buffer *buf)
+{
+	assert(buf->process_base < buf->len);
+
+	const struct payload_vtable *vtable = buf->vtables[buf->process_base];
+	struct soa_column *column = find_column(buf, vtable);
+
+	// methods take a whole payload, which is put back together from the
+	// vtable and its row
+	struct payload p = { .vtable = vtable };
+
+	if (vtable->data_size > 0)
+		memcpy(&p.data, column->rows +
+		       column->processed * vtable->data_size,
+		       vtable->data_size);
+
+	column->processed++;
+	vtable->process(&p);
+
+	buf->process_base += 1;
+}
+
+void soa_destroy(struct soa_payload_buffer *buf)
+{
+	arena_release(&buf->strings);
+
+	for (int i = 0; i < buf->column_count; i++)
+		free(buf->columns[i].rows);
+
+	free(buf->columns);
+	free(buf->vtables);
+	free(buf);
+}
+
+int soa_count(const struct soa_payload_buffer *buf,
+	      const struct payload_vtable *vtable)
+{
+	int count = 0;
+
+	for (int i = 0; i < buf->len; i++)
+		count += buf->vtables[i] == vtable;
+
+	return count;
+}
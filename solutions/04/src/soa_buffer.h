@@ -0,0 +1,70 @@
+/**
+ * @file soa_buffer.h
+ * @brief Structure-of-arrays variant of payload_buffer.
+ *
+ * payload_buffer stores whole payloads, each a vtable pointer followed by a
+ * union sized for the largest variant. Here the vtable pointers are kept in
+ * one dense array and the data of each variant in a column of its own, so
+ * passes that only need the type of payloads touch 8 bytes per payload.
+ *
+ * Payloads of one vtable are stored in their column in arrival order, so the
+ * row of the next payload to process is simply the number of payloads of its
+ * column processed so far.
+ */
+
+
+#ifndef SOA_BUFFER_H
+#define SOA_BUFFER_H
+
+
+#include "arena.h"
+#include "structural_index.h"
+
+
+struct payload_vtable;
+
+
+/**
+ * @brief Data of every payload sharing one vtable.
+ */
+struct soa_column {
+	const struct payload_vtable *vtable;
+	char *rows;     /**< vtable->data_size bytes per payload */
+	int len;
+	int cap;
+	int processed;  /**< Rows already processed */
+};
+
+/**
+ * @brief Payload buffer with the same API as payload_buffer.
+ */
+struct soa_payload_buffer {
+	const struct payload_vtable **vtables;  /**< One per payload */
+	int len;
+	int cap;
+	int process_base;
+
+	struct soa_column *columns;  /**< One per distinct vtable */
+	int column_count;
+
+	struct arena strings;
+};
+
+
+struct soa_payload_buffer *soa_new_buffer();
+
+void soa_push_payload(struct soa_payload_buffer *buf,
+		      const struct payload_line *line);
+
+void soa_process_next(struct soa_payload_buffer *buf);
+
+void soa_destroy(struct soa_payload_buffer *buf);
+
+/**
+ * @brief Counts payloads of the given vtable, reading only the vtable array.
+ */
+int soa_count(const struct soa_payload_buffer *buf,
+	      const struct payload_vtable *vtable);
+
+
+#endif
@@ -0,0 +1,83 @@
+#include "spsc_ring.h"
+
+#include <assert.h>
+#include <sched.h>
+#include <stdlib.h>
+
+
+void spsc_init(struct spsc_ring *ring, size_t capacity)
+{
+	size_t size = 1;
+	while (size < capacity)
+		size *= 2;
+
+	ring->slots = malloc(size * sizeof(void *));
+	assert(ring->slots);
+
+	ring->mask = size - 1;
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->tail, 0);
+	ring->cached_head = ring->cached_tail = 0;
+}
+
+bool spsc_push(struct spsc_ring *ring, void *item)
+{
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+	if (tail - ring->cached_head > ring->mask) {
+		ring->cached_head = atomic_load_explicit(
+			&ring->head, memory_order_acquire);
+
+		if (tail - ring->cached_head > ring->mask)
+			return false;
+	}
+
+	ring->slots[tail & ring->mask] = item;
+
+	// publishes the slot before the consumer can see the new tail
+	atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+	return true;
+}
+
+bool spsc_pop(struct spsc_ring *ring, void **item)
+{
+	size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+	if (head == ring->cached_tail) {
+		ring->cached_tail = atomic_load_explicit(
+			&ring->tail, memory_order_acquire);
+
+		if (head == ring->cached_tail)
+			return false;
+	}
+
+	*item = ring->slots[head & ring->mask];
+
+	// hands the slot back to the producer after it has been read
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+	return true;
+}
+
+void spsc_push_wait(struct spsc_ring *ring, void *item)
+{
+	while (!spsc_push(ring, item))
+		sched_yield();
+}
+
+void *spsc_pop_wait(struct spsc_ring *ring)
+{
+	void *item;
+
+	while (!spsc_pop(ring, &item))
+		sched_yield();
+
+	return item;
+}
+
+void spsc_free(struct spsc_ring *ring)
+{
+	free(ring->slots);
+	ring->slots = NULL;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file spsc_ring.h
+ * @brief Bounded lock-free ring between exactly one producer and one consumer.
+ *
+ * The producer only writes tail and the consumer only writes head, so both
+ * sides make progress with plain atomic loads and stores and no locks. Each
+ * side keeps a cached copy of the other side's index and only rereads the
+ * shared one when the cached copy says the ring is full (or empty).
+ */
+
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/** @brief Assumed cache line size, indices live on lines of their own. */
+#define CACHE_LINE 64
+
+
+/**
+ * @brief Ring of pointers.
+ */
+struct spsc_ring {
+	void **slots;
+	size_t mask;  /**< Capacity minus one, capacity is a power of 2 */
+
+	alignas(CACHE_LINE) atomic_size_t head;  /**< Next slot to pop */
+	size_t cached_tail;                      /**< Consumer's copy */
+
+	alignas(CACHE_LINE) atomic_size_t tail;  /**< Next slot to push */
+	size_t cached_head;                      /**< Producer's copy */
+};
+
+
+/**
+ * @brief Initializes an empty ring.
+ *
+ * @param capacity Number of slots, rounded up to a power of 2
+ */
+void spsc_init(struct spsc_ring *ring, size_t capacity);
+
+/**
+ * @brief Pushes item, called by the producer only.
+ *
+ * @return false if the ring is full
+ */
+bool spsc_push(struct spsc_ring *ring, void *item);
+
+/**
+ * @brief Pops the oldest item, called by the consumer only.
+ *
+ * @return false if the ring is empty
+ */
+bool spsc_pop(struct spsc_ring *ring, void **item);
+
+/**
+ * @brief Pushes item, yielding the CPU while the ring is full.
+ */
+void spsc_push_wait(struct spsc_ring *ring, void *item);
+
+/**
+ * @brief Pops the oldest item, yielding the CPU while the ring is empty.
+ */
+void *spsc_pop_wait(struct spsc_ring *ring);
+
+/**
+ * @brief Frees the slots of the ring. Items left in it are not touched.
+ */
+void spsc_free(struct spsc_ring *ring);
+
+
+#endif
@@ -0,0 +1,230 @@
+#include "structural_index.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+
+/* vectorized scans classify the block 64 bytes at a time */
+#define CHUNK 64
+
+
+static void reserve(struct structural_index *idx, size_t marks, size_t lines)
+{
+	if (idx->mark_count + marks > idx->mark_cap) {
+		idx->mark_cap = (idx->mark_count + marks) * 2;
+		idx->marks = realloc(idx->marks,
+				     idx->mark_cap * sizeof(uint32_t));
+		assert(idx->marks);
+	}
+
+	if (idx->line_count + lines > idx->line_cap) {
+		idx->line_cap = (idx->line_count + lines) * 2;
+		idx->lines = realloc(idx->lines,
+				     idx->line_cap * sizeof(struct line_end));
+		assert(idx->lines);
+	}
+}
+
+static void begin(struct structural_index *idx, [[maybe_unused]] size_t len)
+{
+	assert(len <= STRUCTURAL_INDEX_MAX_BLOCK);
+
+	idx->mark_count = idx->line_count = 0;
+}
+
+/* terminates the last line if the block does not end with a newline */
+static void finish(struct structural_index *idx, const char *block, size_t len)
+{
+	if (len > 0 && block[len - 1] != '\n') {
+		reserve(idx, 0, 1);
+
+		idx->lines[idx->line_count++] = (struct line_end) {
+			.offset = len,
+			.mark_end = idx->mark_count,
+		};
+	}
+}
+
+static inline bool is_mark(char c)
+{
+	return c == ' ' || c == '/' || c == '@' || c == '#';
+}
+
+static void scan_scalar(struct structural_index *idx, const char *block,
+			size_t from, size_t to)
+{
+	for (size_t i = from; i < to; i++) {
+		if ((i - from) % CHUNK == 0)
+			reserve(idx, CHUNK, CHUNK);
+
+		if (block[i] == '\n')
+			idx->lines[idx->line_count++] = (struct line_end) {
+				.offset = i,
+				.mark_end = idx->mark_count,
+			};
+		else if (is_mark(block[i]))
+			idx->marks[idx->mark_count++] = i;
+	}
+}
+
+void build_structural_index_scalar(struct structural_index *idx,
+				   const char *block, size_t len)
+{
+	begin(idx, len);
+	scan_scalar(idx, block, 0, len);
+	finish(idx, block, len);
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/* Appends the set bits of one 64-byte chunk. Each newline records how many
+ * marks precede it, which is the running count plus the marks of this chunk
+ * below the newline's bit. */
+static inline void emit_chunk(struct structural_index *idx, uint32_t base,
+			      uint64_t marks, uint64_t newlines)
+{
+	while (newlines) {
+		int bit = __builtin_ctzll(newlines);
+
+		idx->lines[idx->line_count++] = (struct line_end) {
+			.offset = base + bit,
+			.mark_end = idx->mark_count + __builtin_popcountll(
+				marks & ((UINT64_C(1) << bit) - 1)),
+		};
+
+		newlines &= newlines - 1;
+	}
+
+	while (marks) {
+		idx->marks[idx->mark_count++] = base + __builtin_ctzll(marks);
+		marks &= marks - 1;
+	}
+}
+
+__attribute__((target("sse2")))
+static inline uint64_t sse2_match(const char *p, char c)
+{
+	__m128i needle = _mm_set1_epi8(c);
+	uint64_t mask = 0;
+
+	for (int i = 0; i < CHUNK / 16; i++) {
+		__m128i bytes = _mm_loadu_si128((const __m128i *) (p + 16 * i));
+
+		mask |= (uint64_t) (uint16_t) _mm_movemask_epi8(
+			_mm_cmpeq_epi8(bytes, needle)) << (16 * i);
+	}
+
+	return mask;
+}
+
+__attribute__((target("sse2")))
+void build_structural_index_sse2(struct structural_index *idx,
+				 const char *block, size_t len)
+{
+	size_t i;
+
+	begin(idx, len);
+
+	for (i = 0; i + CHUNK <= len; i += CHUNK) {
+		const char *p = block + i;
+
+		reserve(idx, CHUNK, CHUNK);
+		emit_chunk(idx, i,
+			   sse2_match(p, ' ') | sse2_match(p, '/') |
+			   sse2_match(p, '@') | sse2_match(p, '#'),
+			   sse2_match(p, '\n'));
+	}
+
+	scan_scalar(idx, block, i, len);
+	finish(idx, block, len);
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t avx2_match(__m256i bytes, char c)
+{
+	return _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes,
+						      _mm256_set1_epi8(c)));
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t avx2_match_any(__m256i lo, __m256i hi,
+				      const char *set, int n)
+{
+	uint32_t lo_mask = 0, hi_mask = 0;
+
+	for (int i = 0; i < n; i++) {
+		lo_mask |= avx2_match(lo, set[i]);
+		hi_mask |= avx2_match(hi, set[i]);
+	}
+
+	return (uint64_t) hi_mask << 32 | lo_mask;
+}
+
+__attribute__((target("avx2")))
+void build_structural_index_avx2(struct structural_index *idx,
+				 const char *block, size_t len)
+{
+	size_t i;
+
+	begin(idx, len);
+
+	for (i = 0; i + CHUNK <= len; i += CHUNK) {
+		__m256i lo = _mm256_loadu_si256((const __m256i *) (block + i));
+		__m256i hi = _mm256_loadu_si256(
+			(const __m256i *) (block + i + 32));
+
+		reserve(idx, CHUNK, CHUNK);
+		emit_chunk(idx, i, avx2_match_any(lo, hi, " /@#", 4),
+			   avx2_match_any(lo, hi, "\n", 1));
+	}
+
+	scan_scalar(idx, block, i, len);
+	finish(idx, block, len);
+}
+
+#endif
+
+
+void build_structural_index(struct structural_index *idx, const char *block,
+			    size_t len)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (__builtin_cpu_supports("avx2"))
+		build_structural_index_avx2(idx, block, len);
+	else if (__builtin_cpu_supports("sse2"))
+		build_structural_index_sse2(idx, block, len);
+	else
+#endif
+		build_structural_index_scalar(idx, block, len);
+}
+
+void indexed_line(const struct structural_index *idx, const char *block,
+		  size_t i, struct payload_line *line)
+{
+	assert(i < idx->line_count);
+
+	uint32_t start = i > 0 ? idx->lines[i - 1].offset + 1 : 0;
+	uint32_t mark_start = i > 0 ? idx->lines[i - 1].mark_end : 0;
+
+	*line = (struct payload_line) {
+		.block = block,
+		.start = start,
+		.end = idx->lines[i].offset,
+		.marks = idx->marks + mark_start,
+		.mark_count = idx->lines[i].mark_end - mark_start,
+	};
+}
+
+void free_structural_index(struct structural_index *idx)
+{
+	free(idx->marks);
+	free(idx->lines);
+
+	*idx = (struct structural_index) { .marks = NULL };
+}
@@ -0,0 +1,96 @@
+/**
+ * @file structural_index.h
+ * @brief Single-pass structural indexing of an input block.
+ *
+ * Before any payload is parsed, the whole block is scanned once and the
+ * offsets of every structural character are recorded: newlines split lines,
+ * spaces split tokens, and sigils ('/', '@', '#') mark commands and
+ * receivers. The parser then walks this index instead of rescanning bytes.
+ *
+ * The scan is vectorized with SSE2 or AVX2 when the CPU supports it; the
+ * implementation is selected at runtime and falls back to a scalar loop.
+ */
+
+
+#ifndef STRUCTURAL_INDEX_H
+#define STRUCTURAL_INDEX_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/** @brief Blocks are indexed with 32-bit offsets. */
+#define STRUCTURAL_INDEX_MAX_BLOCK ((size_t) UINT32_MAX)
+
+
+/**
+ * @brief End of one line within a block.
+ */
+struct line_end {
+	uint32_t offset;    /**< Offset of the newline, or the block length */
+	uint32_t mark_end;  /**< Number of marks before the newline */
+};
+
+/**
+ * @brief Structural index of a block. Zero-initialize before first use.
+ *
+ * Arrays are reused between blocks and only grow.
+ */
+struct structural_index {
+	uint32_t *marks;          /**< Offsets of ' ', '/', '@' and '#' */
+	size_t mark_count;
+	size_t mark_cap;
+
+	struct line_end *lines;   /**< One entry per line, in order */
+	size_t line_count;
+	size_t line_cap;
+};
+
+/**
+ * @brief One line of a block, with the structural marks that fall into it.
+ */
+struct payload_line {
+	const char *block;      /**< Block the offsets are relative to */
+	uint32_t start;         /**< Offset of the first byte of the line */
+	uint32_t end;           /**< Offset one past the last byte */
+	const uint32_t *marks;  /**< Marks inside [start, end) in order */
+	size_t mark_count;
+};
+
+
+/**
+ * @brief Indexes block with the fastest implementation the CPU supports.
+ *
+ * A last line without a trailing newline is indexed as a line as well.
+ *
+ * @param idx Index to overwrite
+ * @param block Input bytes, at most STRUCTURAL_INDEX_MAX_BLOCK long
+ * @param len Length of the block
+ */
+void build_structural_index(struct structural_index *idx, const char *block,
+			    size_t len);
+
+/* implementations, exposed for benchmarking */
+void build_structural_index_scalar(struct structural_index *idx,
+				   const char *block, size_t len);
+#if defined(__x86_64__) || defined(__i386__)
+void build_structural_index_sse2(struct structural_index *idx,
+				 const char *block, size_t len);
+void build_structural_index_avx2(struct structural_index *idx,
+				 const char *block, size_t len);
+#endif
+
+/**
+ * @brief Fills line with the i-th line of an indexed block.
+ */
+void indexed_line(const struct structural_index *idx, const char *block,
+		  size_t i, struct payload_line *line);
+
+/**
+ * @brief Frees the arrays of the index.
+ */
+void free_structural_index(struct structural_index *idx);
+
+
+#endif
@@ -0,0 +1,509 @@
+#include "wire_format.h"
+#include "arena.h"
+#include "intern.h"
+#include "payload.h"
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char magic[4] = { 'P', 'L', 'W', '1' };
+
+
+/* growing output of the encoder */
+struct writer {
+	char *data;
+	size_t len;
+	size_t cap;
+};
+
+static void *reserve(struct writer *w, size_t n)
+{
+	if (w->len + n > w->cap) {
+		w->cap = w->cap ? w->cap * 2 : 4096;
+		while (w->len + n > w->cap)
+			w->cap *= 2;
+
+		w->data = realloc(w->data, w->cap);
+		assert(w->data);
+	}
+
+	void *at = w->data + w->len;
+	w->len += n;
+	return at;
+}
+
+static void put(struct writer *w, const void *src, size_t n)
+{
+	memcpy(reserve(w, n), src, n);
+}
+
+static void put_u8(struct writer *w, uint8_t x)
+{
+	put(w, &x, sizeof(x));
+}
+
+/* 7 bits per byte, least significant first, the top bit set on all but the
+ * last byte */
+static void put_varint(struct writer *w, uint32_t x)
+{
+	uint8_t bytes[5];
+	size_t n = 0;
+
+	for (; x >= 0x80; x >>= 7)
+		bytes[n++] = x | 0x80;
+	bytes[n++] = x;
+
+	put(w, bytes, n);
+}
+
+/* length, bytes and terminator of str */
+static void put_string(struct writer *w, const char *str)
+{
+	size_t len = strlen(str);
+
+	assert(len <= UINT32_MAX);
+	put_varint(w, len);
+	put(w, str, len + 1);
+}
+
+
+/* index of every distinct name in the name table of an encoding */
+struct name_slot {
+	const char *name;
+	uint32_t index;
+};
+
+struct name_table {
+	struct name_slot *slots;
+	size_t mask;
+	uint32_t count;
+	struct writer names;  /**< The encoded table */
+};
+
+static void grow_names(struct name_table *t)
+{
+	size_t cap = (t->mask + 1) * 2;
+	struct name_slot *slots = calloc(cap, sizeof(struct name_slot));
+	assert(slots);
+
+	for (size_t i = 0; i <= t->mask; i++) {
+		if (t->slots[i].name == NULL)
+			continue;
+
+		size_t j = interned_id(t->slots[i].name) * 2654435761u &
+			(cap - 1);
+		while (slots[j].name != NULL)
+			j = (j + 1) & (cap - 1);
+
+		slots[j] = t->slots[i];
+	}
+
+	free(t->slots);
+	t->slots = slots;
+	t->mask = cap - 1;
+}
+
+/* index of an interned name, adding it to the table on first use */
+static uint32_t name_index(struct name_table *t, const char *name)
+{
+	size_t i = interned_id(name) * 2654435761u & t->mask;
+
+	for (; t->slots[i].name != NULL; i = (i + 1) & t->mask)
+		if (t->slots[i].name == name)
+			return t->slots[i].index;
+
+	put_string(&t->names, name);
+
+	t->slots[i] = (struct name_slot) { .name = name, .index = t->count };
+
+	// keep the load factor at most 1/2
+	if (++t->count * 2 > t->mask + 1)
+		grow_names(t);
+
+	return t->count - 1;
+}
+
+static void put_record(struct writer *w, struct name_table *names,
+		       const struct payload *p)
+{
+	if (p->vtable == &command_login_vtable) {
+		put_u8(w, WIRE_LOGIN);
+		put_varint(w, name_index(names,
+					 p->data.command_login.username));
+		put_string(w, p->data.command_login.password);
+	} else if (p->vtable == &command_join_vtable) {
+		put_u8(w, WIRE_JOIN);
+		put_varint(w, name_index(names, p->data.command_join.channel));
+	} else if (p->vtable == &command_logout_vtable) {
+		put_u8(w, WIRE_LOGOUT);
+	} else {
+		assert(p->vtable == &message_vtable);
+
+		const struct message_receiving_entity *receivers = \
+			message_receivers(&p->data);
+		int count = p->data.message.receiver_count;
+
+		// a global message is a single receiver without a name
+		if (receivers[0].vtable == &global_message_vtable)
+			count = 0;
+
+		put_u8(w, WIRE_MESSAGE);
+		put_varint(w, count);
+
+		for (int i = 0; i < count; i++) {
+			const struct message_receiving_entity *r = \
+				&receivers[i];
+			uint32_t name = name_index(names, r->additional_info);
+			bool is_group = r->vtable == &group_message_vtable;
+
+			put_varint(w, name << 1 | is_group);
+		}
+
+		put_string(w, p->data.message.content);
+	}
+}
+
+/* scratch space of the encoder, kept between calls so that encoding one
+ * payload at a time allocates nothing */
+static _Thread_local struct name_table scratch_names;
+static _Thread_local struct writer scratch_records, scratch_record;
+
+void serialize_payloads_append(const struct payload *payloads, int count,
+			       char **out, size_t *len, size_t *cap)
+{
+	struct name_table *names = &scratch_names;
+
+	if (names->slots == NULL) {
+		names->slots = calloc(16, sizeof(struct name_slot));
+		assert(names->slots);
+		names->mask = 15;
+	} else {
+		memset(names->slots, 0,
+		       (names->mask + 1) * sizeof(struct name_slot));
+	}
+	names->count = 0;
+	names->names.len = 0;
+
+	struct writer *records = &scratch_records, *record = &scratch_record;
+	records->len = 0;
+
+	for (int i = 0; i < count; i++) {
+		// the length goes in front, so the record is written aside
+		record->len = 0;
+		put_record(record, names, &payloads[i]);
+
+		put_varint(records, record->len);
+		put(records, record->data, record->len);
+	}
+
+	struct writer w = { .data = *out, .len = *len, .cap = *cap };
+
+	put(&w, magic, sizeof(magic));
+	put_varint(&w, names->count);
+	put(&w, names->names.data, names->names.len);
+	put_varint(&w, count);
+	put(&w, records->data, records->len);
+
+	*out = w.data;
+	*len = w.len;
+	*cap = w.cap;
+}
+
+char *serialize_payloads(const struct payload *payloads, int count,
+			 size_t *len)
+{
+	char *out = NULL;
+	size_t cap = 0;
+
+	*len = 0;
+	serialize_payloads_append(payloads, count, &out, len, &cap);
+
+	return out;
+}
+
+
+/* bounds-checked input of the decoder */
+struct reader {
+	const char *at;
+	const char *end;
+};
+
+static bool get(struct reader *r, void *dst, size_t n)
+{
+	if ((size_t) (r->end - r->at) < n)
+		return false;
+
+	memcpy(dst, r->at, n);
+	r->at += n;
+	return true;
+}
+
+static bool get_u8(struct reader *r, uint8_t *x)
+{
+	return get(r, x, sizeof(*x));
+}
+
+static bool get_varint(struct reader *r, uint32_t *x)
+{
+	uint32_t value = 0;
+
+	for (int shift = 0; shift < 35 && r->at < r->end; shift += 7) {
+		uint8_t byte = *r->at++;
+
+		value |= (uint32_t) (byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			*x = value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* skips len bytes and a terminator, returning where they start */
+static const char *get_string(struct reader *r, size_t len)
+{
+	if ((size_t) (r->end - r->at) <= len || r->at[len] != '\0')
+		return NULL;
+
+	const char *str = r->at;
+	r->at += len + 1;
+	return str;
+}
+
+/* decodes one record into p; strings point into the same offsets of copy,
+ * the records as copied into the arena */
+static bool get_record(struct reader *r, struct payload *p,
+		       const char **names, uint32_t name_count,
+		       const char *records, char *copy, struct arena *strings)
+{
+	uint8_t kind;
+	uint32_t index, len;
+	const char *str;
+
+	if (!get_u8(r, &kind))
+		return false;
+
+	switch (kind) {
+	case WIRE_LOGIN:
+		if (!get_varint(r, &index) || index >= name_count ||
+		    !get_varint(r, &len) || !(str = get_string(r, len)))
+			return false;
+
+		p->vtable = &command_login_vtable;
+		p->data.command_login.username = names[index];
+		p->data.command_login.password = copy + (str - records);
+		return true;
+
+	case WIRE_JOIN:
+		if (!get_varint(r, &index) || index >= name_count)
+			return false;
+
+		p->vtable = &command_join_vtable;
+		p->data.command_join.channel = names[index];
+		return true;
+
+	case WIRE_LOGOUT:
+		p->vtable = &command_logout_vtable;
+		return true;
+
+	case WIRE_MESSAGE:
+		break;
+
+	default:
+		return false;
+	}
+
+	// every receiver takes at least one byte, which bounds the allocation
+	uint32_t count;
+	if (!get_varint(r, &count) || count > (size_t) (r->end - r->at))
+		return false;
+
+	p->vtable = &message_vtable;
+	p->data.message.receiver_count = count > 0 ? count : 1;
+
+	struct message_receiving_entity *receivers = \
+		p->data.message.inline_receivers;
+
+	if (count > MESSAGE_INLINE_RECEIVERS) {
+		receivers = arena_alloc(strings,
+			sizeof(struct message_receiving_entity) * count,
+			alignof(struct message_receiving_entity));
+		p->data.message.receivers = receivers;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (!get_varint(r, &index) || index >> 1 >= name_count)
+			return false;
+
+		receivers[i] = (struct message_receiving_entity) {
+			.additional_info = names[index >> 1],
+			.vtable = index & 1 ?
+				&group_message_vtable : &direct_message_vtable,
+		};
+	}
+
+	if (count == 0)
+		receivers[0] = (struct message_receiving_entity) {
+			.vtable = &global_message_vtable,
+		};
+
+	if (!get_varint(r, &len) || !(str = get_string(r, len)))
+		return false;
+
+	p->data.message.content = copy + (str - records);
+	return true;
+}
+
+/* names of the encoding being decoded, reused across a run */
+struct name_scratch {
+	const char **names;
+	uint32_t cap;
+};
+
+/* decodes one encoding into buf, or leaves buf as it was */
+static bool decode(struct payload_buffer *buf, const char *data, size_t len,
+		   struct name_scratch *scratch)
+{
+	assert(buf->high_water == 0);
+
+	struct reader r = { .at = data, .end = data + len };
+	char found[sizeof(magic)];
+	uint32_t name_count, record_count;
+
+	if (!get(&r, found, sizeof(found)) ||
+	    memcmp(found, magic, sizeof(magic)) != 0 ||
+	    !get_varint(&r, &name_count) ||
+	    // every name takes at least 2 bytes
+	    name_count > (size_t) (r.end - r.at) / 2)
+		return false;
+
+	if (name_count > scratch->cap) {
+		scratch->cap = name_count;
+		scratch->names = realloc(scratch->names,
+					 name_count * sizeof(*scratch->names));
+		assert(scratch->names);
+	}
+
+	const char **names = scratch->names;
+	bool valid = true;
+
+	for (uint32_t i = 0; valid && i < name_count; i++) {
+		uint32_t name_len;
+		const char *name = NULL;
+
+		valid = get_varint(&r, &name_len) &&
+			(name = get_string(&r, name_len));
+		if (valid)
+			names[i] = intern(name, name_len);
+	}
+
+	// every record takes at least 2 bytes
+	if (!valid || !get_varint(&r, &record_count) ||
+	    record_count > (size_t) (r.end - r.at) / 2)
+		return false;
+
+	// the records are copied as a whole, strings keep their offsets; the
+	// arena is rolled back unless every record is valid
+	struct arena_mark mark = arena_save(&buf->strings);
+	const char *records = r.at;
+	size_t records_len = r.end - r.at;
+	char *copy = arena_alloc(&buf->strings, records_len ? records_len : 1,
+				 1);
+	memcpy(copy, records, records_len);
+
+	int cap = buf->cap;
+
+	// doubling, a run of small encodings grows the array a logarithmic
+	// number of times
+	if (buf->len + (size_t) record_count > (size_t) buf->cap) {
+		size_t needed = buf->len + (size_t) record_count;
+		size_t doubled = (size_t) buf->cap * 2;
+
+		assert(needed <= INT32_MAX);
+
+		buf->cap = doubled > needed && doubled <= INT32_MAX ?
+			doubled : needed;
+		buf->payloads = realloc(buf->payloads,
+					buf->cap * sizeof(struct payload));
+		assert(buf->payloads);
+	}
+
+	int appended = 0;
+
+	for (; valid && (uint32_t) appended < record_count; appended++) {
+		uint32_t record_len;
+
+		if (!get_varint(&r, &record_len) ||
+		    record_len > (size_t) (r.end - r.at)) {
+			valid = false;
+			break;
+		}
+
+		struct reader record = { .at = r.at, .end = r.at + record_len };
+
+		valid = get_record(&record, &buf->payloads[buf->len + appended],
+				   names, name_count, records, copy,
+				   &buf->strings) &&
+			record.at == record.end;
+		r.at += record_len;
+	}
+
+	if (!valid || r.at != r.end) {
+		arena_rollback(&buf->strings, mark);
+
+		if (buf->cap != cap) {
+			buf->cap = cap;
+			buf->payloads = realloc(buf->payloads,
+						cap * sizeof(struct payload));
+			assert(buf->payloads);
+		}
+
+		return false;
+	}
+
+	buf->len += appended;
+	return true;
+}
+
+bool deserialize_payloads(struct payload_buffer *buf, const char *data,
+			  size_t len)
+{
+	struct name_scratch scratch = { .names = NULL };
+	bool valid = decode(buf, data, len, &scratch);
+
+	free(scratch.names);
+	return valid;
+}
+
+size_t deserialize_payload_run(struct payload_buffer *buf, const char *data,
+			       size_t len, size_t *used)
+{
+	struct name_scratch scratch = { .names = NULL };
+	size_t count = 0, offset = 0;
+
+	for (;;) {
+		uint32_t encoding_len;
+
+		if (len - offset < sizeof(encoding_len))
+			break;
+		memcpy(&encoding_len, data + offset, sizeof(encoding_len));
+
+		if (len - offset - sizeof(encoding_len) < encoding_len ||
+		    !decode(buf, data + offset + sizeof(encoding_len),
+			    encoding_len, &scratch))
+			break;
+
+		offset += sizeof(encoding_len) + encoding_len;
+		count++;
+	}
+
+	free(scratch.names);
+
+	*used = offset;
+	return count;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file wire_format.h
+ * @brief Compact binary encoding of parsed payloads.
+ *
+ * Parsing text means finding tokens and hashing every name into the intern
+ * pool. Encoded payloads name users and channels by their index into a
+ * table of distinct names at the front, and every string is stored with its
+ * length and a terminator, so decoding interns each distinct name once and
+ * otherwise only adds offsets.
+ *
+ * Every number is a varint: 7 bits per byte, least significant first, the
+ * top bit set on every byte but the last. An encoding is
+ *
+ *     "PLW1"
+ *     name count, then per name: length, bytes, NUL
+ *     record count, then per record: length, record bytes
+ *
+ * and a record is a kind byte followed by
+ *
+ *     WIRE_LOGIN    user, password length, bytes, NUL
+ *     WIRE_JOIN     channel
+ *     WIRE_LOGOUT   nothing
+ *     WIRE_MESSAGE  receiver count, per receiver name << 1 | is group,
+ *                   content length, bytes, NUL
+ *
+ * where users and channels are name indices and a message without
+ * receivers is global.
+ */
+
+
+#ifndef WIRE_FORMAT_H
+#define WIRE_FORMAT_H
+
+
+#include "dynamic_dispatch.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+enum wire_kind {
+	WIRE_LOGIN,
+	WIRE_JOIN,
+	WIRE_LOGOUT,
+	WIRE_MESSAGE,
+};
+
+
+/**
+ * @brief Encodes count payloads.
+ *
+ * @param payloads Parsed payloads of the types in payload.h
+ * @param count Number of payloads
+ * @param len Output for the length of the encoding
+ * @return The encoding, to be released with free
+ */
+char *serialize_payloads(const struct payload *payloads, int count,
+			 size_t *len);
+
+/**
+ * @brief Encodes count payloads at the end of a growing buffer.
+ *
+ * Encoding one payload at a time this way allocates nothing once the
+ * buffers have grown.
+ *
+ * @param out Buffer allocated with malloc, or NULL, grown with realloc
+ * @param len Bytes of out in use, moved past the encoding
+ * @param cap Capacity of out
+ */
+void serialize_payloads_append(const struct payload *payloads, int count,
+			       char **out, size_t *len, size_t *cap);
+
+/**
+ * @brief Decodes an encoding and appends its payloads to buf.
+ *
+ * Strings are copied into the arena of buf, data may go away afterwards.
+ *
+ * @return False if data is not a valid encoding, buf is left as it was
+ *         then; names decoded before the error stay in the intern pool
+ */
+bool deserialize_payloads(struct payload_buffer *buf, const char *data,
+			  size_t len);
+
+/**
+ * @brief Decodes a run of encodings, each behind its length as a native
+ *        u32, and appends their payloads to buf.
+ *
+ * Scratch space and the growth of the payload array are shared by the whole
+ * run, so a run of single-payload encodings costs little more per payload
+ * than one encoding of them all. Decoding stops before the first encoding
+ * that is cut short or invalid, nothing of it is appended.
+ *
+ * @param used Output for the bytes of data taken by the decoded encodings
+ * @return Number of encodings decoded
+ */
+size_t deserialize_payload_run(struct payload_buffer *buf, const char *data,
+			       size_t len, size_t *used);
+
+
+#endif
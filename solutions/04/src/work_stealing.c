@@ -0,0 +1,352 @@
+#include "work_stealing.h"
+#include "intern.h"
+#include "payload.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/* last payload seen with a name, -1 for a newly claimed slot */
+struct name_slot {
+	const char *name;
+	int last;
+};
+
+struct edge {
+	int from;
+	int to;
+};
+
+/* dependency graph of the pending payloads, successors of payload i are
+ * successors[first_successor[i]] up to first_successor[i + 1] */
+struct graph {
+	atomic_int *waiting;  /**< Unprocessed predecessors of each payload */
+	int *first_successor;
+	int *successors;
+};
+
+/* ready payloads of one worker; the owner works at the bottom, thieves take
+ * from the top */
+struct deque {
+	pthread_mutex_t lock;
+	int *items;
+	int top;
+	int bottom;
+	int cap;
+};
+
+struct scheduler {
+	struct payload *payloads;
+	struct graph graph;
+	struct deque *deques;
+	int worker_count;
+	atomic_int remaining;
+};
+
+struct worker {
+	struct scheduler *sched;
+	int id;
+};
+
+
+static struct name_slot *find_name(struct name_slot *slots, size_t mask,
+				   const char *name)
+{
+	// names are interned, the ID is a perfect key and the pointer is
+	// compared instead of the bytes
+	uint32_t h = interned_id(name) * 2654435761u;
+
+	for (size_t i = h & mask;; i = (i + 1) & mask) {
+		if (slots[i].name == NULL)
+			slots[i] = (struct name_slot) {
+				.name = name,
+				.last = -1,
+			};
+
+		if (slots[i].name == name)
+			return &slots[i];
+	}
+}
+
+static void add_edge(struct edge **edges, int *len, int *cap, int from, int to)
+{
+	if (*len == *cap) {
+		*cap = *cap ? *cap * 2 : 64;
+		*edges = realloc(*edges, *cap * sizeof(struct edge));
+		assert(*edges);
+	}
+
+	(*edges)[(*len)++] = (struct edge) { .from = from, .to = to };
+}
+
+static struct graph build_graph(const struct payload *payloads, int n)
+{
+	size_t name_count = 0;
+
+	for (int i = 0; i < n; i++) {
+		const struct payload *p = &payloads[i];
+
+		if (p->vtable->name)
+			for (int k = 0; p->vtable->name(p, k); k++)
+				name_count++;
+	}
+
+	// keep the load factor at most 1/2
+	size_t cap = 2;
+	while (cap < name_count * 2)
+		cap *= 2;
+
+	struct name_slot *slots = calloc(cap, sizeof(struct name_slot));
+	assert(slots);
+
+	struct edge *edges = NULL;
+	int edge_count = 0, edge_cap = 0;
+	int barrier = -1;
+
+	for (int i = 0; i < n; i++) {
+		const struct payload *p = &payloads[i];
+
+		if (p->vtable->name == NULL) {
+			// waits for everything since the previous barrier, or
+			// for that barrier if there is nothing in between
+			for (int j = barrier + 1; j < i; j++)
+				add_edge(&edges, &edge_count, &edge_cap, j, i);
+			if (barrier >= 0 && barrier == i - 1)
+				add_edge(&edges, &edge_count, &edge_cap,
+					 barrier, i);
+
+			barrier = i;
+			continue;
+		}
+
+		if (barrier >= 0)
+			add_edge(&edges, &edge_count, &edge_cap, barrier, i);
+
+		const char *name;
+		for (int k = 0; (name = p->vtable->name(p, k)); k++) {
+			struct name_slot *slot = find_name(slots, cap - 1,
+							   name);
+
+			// anything before the barrier is waited for already
+			if (slot->last > barrier && slot->last != i)
+				add_edge(&edges, &edge_count, &edge_cap,
+					 slot->last, i);
+
+			slot->last = i;
+		}
+	}
+
+	free(slots);
+
+	struct graph g = {
+		.waiting = malloc(n * sizeof(atomic_int)),
+		.first_successor = calloc(n + 1, sizeof(int)),
+		.successors = malloc((edge_count + 1) * sizeof(int)),
+	};
+	assert(g.waiting && g.first_successor && g.successors);
+
+	for (int i = 0; i < n; i++)
+		atomic_init(&g.waiting[i], 0);
+
+	// edges are sorted by target, a counting sort groups them by source
+	for (int e = 0; e < edge_count; e++) {
+		g.first_successor[edges[e].from + 1]++;
+		atomic_fetch_add_explicit(&g.waiting[edges[e].to], 1,
+					  memory_order_relaxed);
+	}
+	for (int i = 0; i < n; i++)
+		g.first_successor[i + 1] += g.first_successor[i];
+
+	int *fill = malloc((n + 1) * sizeof(int));
+	assert(fill);
+	memcpy(fill, g.first_successor, (n + 1) * sizeof(int));
+
+	for (int e = 0; e < edge_count; e++)
+		g.successors[fill[edges[e].from]++] = edges[e].to;
+
+	free(fill);
+	free(edges);
+
+	return g;
+}
+
+static void push_bottom(struct deque *d, int task)
+{
+	pthread_mutex_lock(&d->lock);
+
+	if (d->bottom == d->cap) {
+		// reclaim the slots thieves emptied before growing
+		if (d->top > 0) {
+			memmove(d->items, d->items + d->top,
+				(d->bottom - d->top) * sizeof(int));
+			d->bottom -= d->top;
+			d->top = 0;
+		}
+
+		if (d->bottom == d->cap) {
+			d->cap = d->cap ? d->cap * 2 : 64;
+			d->items = realloc(d->items, d->cap * sizeof(int));
+			assert(d->items);
+		}
+	}
+
+	d->items[d->bottom++] = task;
+
+	pthread_mutex_unlock(&d->lock);
+}
+
+static bool pop_bottom(struct deque *d, int *task)
+{
+	pthread_mutex_lock(&d->lock);
+
+	bool found = d->top < d->bottom;
+	if (found)
+		*task = d->items[--d->bottom];
+	if (d->top == d->bottom)
+		d->top = d->bottom = 0;
+
+	pthread_mutex_unlock(&d->lock);
+
+	return found;
+}
+
+static bool steal_top(struct deque *d, int *task)
+{
+	pthread_mutex_lock(&d->lock);
+
+	bool found = d->top < d->bottom;
+	if (found)
+		*task = d->items[d->top++];
+
+	pthread_mutex_unlock(&d->lock);
+
+	return found;
+}
+
+static void run(struct scheduler *sched, struct deque *own, int task)
+{
+	struct payload *p = &sched->payloads[task];
+	p->vtable->process(p);
+
+	const struct graph *g = &sched->graph;
+
+	// the last predecessor to finish makes a successor ready
+	for (int s = g->first_successor[task];
+	     s < g->first_successor[task + 1]; s++) {
+		int next = g->successors[s];
+
+		if (atomic_fetch_sub_explicit(&g->waiting[next], 1,
+					      memory_order_acq_rel) == 1)
+			push_bottom(own, next);
+	}
+
+	atomic_fetch_sub_explicit(&sched->remaining, 1, memory_order_release);
+}
+
+static void *work(void *arg)
+{
+	struct worker *w = arg;
+	struct scheduler *sched = w->sched;
+	struct deque *own = &sched->deques[w->id];
+
+	while (atomic_load_explicit(&sched->remaining,
+				    memory_order_acquire) > 0) {
+		int task;
+
+		if (pop_bottom(own, &task)) {
+			run(sched, own, task);
+			continue;
+		}
+
+		bool stolen = false;
+		for (int k = 1; k < sched->worker_count && !stolen; k++) {
+			int victim = (w->id + k) % sched->worker_count;
+			stolen = steal_top(&sched->deques[victim], &task);
+		}
+
+		if (stolen)
+			run(sched, own, task);
+		else
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+int process_parallel(struct payload_buffer *buf, int workers)
+{
+	assert(buf->high_water == 0);
+
+	// only this thread would write through it, the others through stdio
+	assert(payload_output == NULL);
+
+	int n = buf->len - buf->process_base;
+	if (n <= 0)
+		return 0;
+
+	if (workers <= 0)
+		workers = sysconf(_SC_NPROCESSORS_ONLN);
+	if (workers <= 0)
+		workers = 1;
+
+	struct scheduler sched = {
+		.payloads = &buf->payloads[buf->process_base],
+		.deques = calloc(workers, sizeof(struct deque)),
+		.worker_count = workers,
+	};
+	assert(sched.deques);
+
+	sched.graph = build_graph(sched.payloads, n);
+	atomic_init(&sched.remaining, n);
+
+	for (int i = 0; i < workers; i++)
+		pthread_mutex_init(&sched.deques[i].lock, NULL);
+
+	// payloads without predecessors are dealt out round-robin
+	for (int i = 0, next = 0; i < n; i++)
+		if (atomic_load_explicit(&sched.graph.waiting[i],
+					 memory_order_relaxed) == 0)
+			push_bottom(&sched.deques[next++ % workers], i);
+
+	struct worker *pool = malloc(workers * sizeof(struct worker));
+	pthread_t *threads = malloc(workers * sizeof(pthread_t));
+	assert(pool && threads);
+
+	for (int i = 0; i < workers; i++) {
+		pool[i] = (struct worker) { .sched = &sched, .id = i };
+
+		if (i > 0) {
+			[[maybe_unused]] int created = pthread_create(
+				&threads[i], NULL, work, &pool[i]);
+			assert(created == 0);
+		}
+	}
+
+	work(&pool[0]);
+
+	for (int i = 1; i < workers; i++)
+		pthread_join(threads[i], NULL);
+
+	for (int i = 0; i < workers; i++) {
+		pthread_mutex_destroy(&sched.deques[i].lock);
+		free(sched.deques[i].items);
+	}
+
+	free(threads);
+	free(pool);
+	free(sched.deques);
+	free(sched.graph.successors);
+	free(sched.graph.first_successor);
+	free((void *) sched.graph.waiting);
+
+	buf->process_base += n;
+
+	return n;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file work_stealing.h
+ * @brief Processing pending payloads on several threads.
+ *
+ * Payloads that share a user or channel name must be processed in arrival
+ * order, everything else may run concurrently. The pending payloads are
+ * turned into a dependency graph first: each payload waits for the previous
+ * payload with any of its names, and payloads concerning every user (such as
+ * logout) wait for everything before them and hold back everything after.
+ *
+ * Payloads become ready once everything they wait for is processed. Every
+ * worker runs ready payloads from its own deque and steals from the other
+ * workers' deques when its own runs dry.
+ */
+
+
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+
+#include "dynamic_dispatch.h"
+
+
+/**
+ * @brief Processes every pending payload of buf using up to workers threads.
+ *
+ * Returns once all of them are processed. The calling thread is one of the
+ * workers.
+ *
+ * Behaviors print through stdio. payload_output is per thread and a sink is
+ * not thread-safe, so the other workers could not share the caller's sink,
+ * and the calling thread must not have one set.
+ *
+ * @param buf Pointer to the payload buffer
+ * @param workers Number of threads, 0 for one per online CPU
+ * @return Number of payloads processed
+ */
+int process_parallel(struct payload_buffer *buf, int workers);
+
+
+#endif
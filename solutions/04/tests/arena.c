@@ -0,0 +1,75 @@
+#include "../src/arena.h"
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+int main()
+{
+	struct arena a = { .chunks = NULL };
+
+	char *hello = arena_strndup(&a, "hello world", 5);
+	assert(strcmp(hello, "hello") == 0);
+
+	// allocations keep their alignment after odd-sized strings
+	for (int i = 0; i < 10000; i++) {
+		arena_strndup(&a, "x", 1);
+
+		long long *n = arena_alloc(&a, sizeof(long long),
+					   alignof(long long));
+		assert((uintptr_t) n % alignof(long long) == 0);
+		*n = i;
+	}
+
+	// larger than any chunk
+	char *big = arena_alloc(&a, 4 << 20, 1);
+	memset(big, 'x', 4 << 20);
+
+	// earlier allocations are untouched by chunk growth
+	assert(strcmp(hello, "hello") == 0);
+
+	arena_release(&a);
+	assert(a.chunks == NULL);
+
+	// a released arena can be reused
+	char *again = arena_strndup(&a, "again", 5);
+
+	// rolling back frees what came after the mark, also in new chunks
+	char *kept = arena_strndup(&a, "kept", 4);
+	struct arena_chunk *chunk = a.chunks;
+
+	struct arena_mark mark = arena_save(&a);
+	arena_strndup(&a, "dropped", 7);
+	arena_rollback(&a, mark);
+	assert(arena_strndup(&a, "again", 5) == kept + 5);
+
+	mark = arena_save(&a);
+	for (int i = 0; i < 10000; i++)
+		arena_strndup(&a, "filler", 6);
+	assert(a.chunks != chunk);
+	arena_rollback(&a, mark);
+	assert(a.chunks == chunk);
+	assert(strcmp(kept, "kept") == 0);
+
+	// adopted allocations survive until the adopting arena is released
+	struct arena b = { .chunks = NULL };
+	char *adopted = arena_strndup(&b, "adopted", 7);
+	for (int i = 0; i < 10000; i++)
+		arena_strndup(&b, "filler", 6);
+
+	arena_adopt(&a, &b);
+	assert(b.chunks == NULL);
+	assert(strcmp(again, "again") == 0);
+	assert(strcmp(adopted, "adopted") == 0);
+
+	// adopting an empty arena changes nothing
+	arena_adopt(&a, &b);
+	arena_release(&b);
+
+	arena_release(&a);
+
+	return EXIT_SUCCESS;
+}
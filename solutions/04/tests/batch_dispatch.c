@@ -0,0 +1,135 @@
+#include "../src/batch_dispatch.h"
+#include "../src/payload.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char CORPUS[] =
+	"/login alice pass\n"
+	"@alice hi\n"
+	"/join general\n"
+	"#general hello\n"
+	"global hello\n"
+	"@bob hey\n"
+	"/login bob pass\n"
+	"@carol @alice both\n"
+	"/logout\n"
+	"@alice after logout\n"
+	"/join general\n"
+	"#general bye\n";
+
+#define PAYLOAD_COUNT 12
+
+
+static const struct payload *first;
+static int processed[PAYLOAD_COUNT];
+static int processed_count;
+
+static void record(const struct payload *self)
+{
+	processed[processed_count++] = self - first;
+}
+
+/* recording copies of the real vtables, distinct per type like the real ones */
+static struct payload_vtable recording[4];
+
+static void load(struct payload_buffer *buf)
+{
+	struct structural_index idx = { .marks = NULL };
+	build_structural_index(&idx, CORPUS, strlen(CORPUS));
+
+	for (size_t i = 0; i < idx.line_count; i++) {
+		struct payload_line line;
+		indexed_line(&idx, CORPUS, i, &line);
+		push_payload(buf, &line);
+	}
+
+	free_structural_index(&idx);
+
+	const struct payload_vtable *real[] = {
+		&command_login_vtable, &command_join_vtable,
+		&command_logout_vtable, &message_vtable,
+	};
+
+	for (int v = 0; v < 4; v++) {
+		recording[v] = *real[v];
+		recording[v].process = record;
+	}
+
+	for (int i = 0; i < buf->len; i++)
+		for (int v = 0; v < 4; v++)
+			if (buf->payloads[i].vtable == real[v])
+				buf->payloads[i].vtable = &recording[v];
+
+	first = buf->payloads;
+	processed_count = 0;
+}
+
+static bool share_name(const struct payload *a, const struct payload *b)
+{
+	if (a->vtable->name == NULL || b->vtable->name == NULL)
+		return true;
+
+	const char *x, *y;
+	for (int i = 0; (x = a->vtable->name(a, i)); i++)
+		for (int j = 0; (y = b->vtable->name(b, j)); j++)
+			if (strcmp(x, y) == 0)
+				return true;
+
+	return false;
+}
+
+int main()
+{
+	struct payload_buffer *buf = new_buffer();
+	int position[PAYLOAD_COUNT];
+
+	// any order: every group is contiguous and in arrival order
+	load(buf);
+	assert(buf->len == PAYLOAD_COUNT);
+	assert(process_batch(buf, 100, BATCH_ANY_ORDER) == PAYLOAD_COUNT);
+	assert(process_batch(buf, 100, BATCH_ANY_ORDER) == 0);
+	assert(processed_count == PAYLOAD_COUNT);
+
+	int groups = 1;
+	for (int i = 1; i < PAYLOAD_COUNT; i++) {
+		const struct payload *a = &first[processed[i - 1]];
+		const struct payload *b = &first[processed[i]];
+
+		if (a->vtable != b->vtable)
+			groups++;
+		else
+			assert(processed[i - 1] < processed[i]);
+	}
+	assert(groups == 4);
+
+	destroy(buf);
+
+	// name order: payloads sharing a name, and barriers, keep their order
+	buf = new_buffer();
+	load(buf);
+
+	// windows split the corpus, which is still processed as a whole
+	assert(process_batch(buf, 5, BATCH_NAME_ORDER) == 5);
+	assert(process_batch(buf, 100, BATCH_NAME_ORDER) == PAYLOAD_COUNT - 5);
+	assert(processed_count == PAYLOAD_COUNT);
+
+	for (int i = 0; i < PAYLOAD_COUNT; i++)
+		position[processed[i]] = i;
+
+	for (int i = 0; i < PAYLOAD_COUNT; i++)
+		for (int j = i + 1; j < PAYLOAD_COUNT; j++)
+			if (share_name(&first[i], &first[j]))
+				assert(position[i] < position[j]);
+
+	// and the batch did group something
+	assert(memcmp(processed, (int []) { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+					    11 }, sizeof(processed)) != 0);
+
+	destroy(buf);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include "../src/dynamic_dispatch.h"
+#include "../src/payload.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char BLOCK[] =
+	"/login alice pass\n"
+	"\n"
+	"@alice hi\n"
+	"/join general\n"
+	"/nonsense\n"
+	"#general hello\n"
+	"global hello";
+
+#define BLOCK_PAYLOADS 5
+
+
+int main()
+{
+	// the same payloads as pushing line by line
+	struct payload_buffer *expected = new_buffer();
+	struct structural_index idx = { .marks = NULL };
+	build_structural_index(&idx, BLOCK, strlen(BLOCK));
+
+	for (size_t i = 0; i < idx.line_count; i++) {
+		struct payload_line line;
+		indexed_line(&idx, BLOCK, i, &line);
+
+		if (line.start != line.end)
+			push_payload(expected, &line);
+	}
+
+	free_structural_index(&idx);
+	assert(expected->len == BLOCK_PAYLOADS);
+
+	struct payload_buffer *buf = new_buffer();
+	assert(push_payloads_bulk(buf, BLOCK, strlen(BLOCK)) ==
+	       BLOCK_PAYLOADS);
+	assert(buf->len == BLOCK_PAYLOADS);
+
+	// one allocation for every line of the block, the empty one included
+	assert(buf->cap == 7);
+
+	for (int i = 0; i < buf->len; i++)
+		assert(buf->payloads[i].vtable == expected->payloads[i].vtable);
+
+	assert(strcmp(buf->payloads[3].data.message.content, "hello") == 0);
+
+	// a block that fits needs no allocation
+	assert(push_payloads_bulk(buf, "@bob hey", 8) == 1);
+	assert(buf->cap == 7);
+
+	// one that does not at least doubles the array
+	assert(push_payloads_bulk(buf, "@bob hey\n@bob ho", 16) == 2);
+	assert(buf->cap == 12);
+
+	assert(push_payloads_bulk(buf, "", 0) == 0);
+	assert(buf->len == BLOCK_PAYLOADS + 3);
+
+	destroy(buf);
+	destroy(expected);
+
+	// reserving is exact, and never shrinks
+	buf = new_buffer();
+	reserve_payloads(buf, 1000);
+	assert(buf->cap == 1000);
+
+	struct payload *payloads = buf->payloads;
+	for (int i = 0; i < 100; i++)
+		push_payloads_bulk(buf, BLOCK, strlen(BLOCK));
+	assert(buf->len == 100 * BLOCK_PAYLOADS);
+	assert(buf->payloads == payloads && buf->cap == 1000);
+
+	reserve_payloads(buf, 0);
+	assert(buf->cap == 1000);
+	destroy(buf);
+
+	// streaming buffers reserve up to their high-water mark
+	buf = new_buffer();
+	stream_buffer(buf, 16);
+	reserve_payloads(buf, 1000);
+	assert(buf->cap == 16);
+	assert(push_payloads_bulk(buf, BLOCK, strlen(BLOCK)) ==
+	       BLOCK_PAYLOADS);
+	destroy(buf);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include "../src/channel_registry.h"
+#include "../src/intern.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define MEMBERS 100000
+
+
+static const char *name(const char *str)
+{
+	return intern(str, strlen(str));
+}
+
+static void collect(const char *user, void *ctx)
+{
+	const char ***out = ctx;
+
+	*(*out)++ = user;
+}
+
+static void count(const char *user, void *ctx)
+{
+	(void) user;
+	(*(uint64_t *) ctx)++;
+}
+
+static void test_membership()
+{
+	const char *general = name("general"), *dev = name("dev");
+	const char *alice = name("alice"), *bob = name("bob");
+
+	assert(channel_size(general) == 0);
+
+	join_channel(general, alice);
+	join_channel(general, bob);
+	join_channel(general, alice);
+	join_channel(dev, bob);
+	assert(channel_size(general) == 2);
+	assert(shared_members(general, dev) == 1);
+
+	// members come in ID order, alice was interned first
+	const char *members[4], **end = members;
+	for_each_member(general, collect, &end);
+	assert(end - members == 2);
+	assert(members[0] == alice && members[1] == bob);
+
+	leave_channels(bob);
+	assert(channel_size(general) == 1);
+	assert(channel_size(dev) == 0);
+	assert(shared_members(general, dev) == 0);
+
+	end = members;
+	for_each_member(dev, collect, &end);
+	assert(end == members);
+
+	clear_channel_registry();
+	assert(channel_size(general) == 0);
+}
+
+static void test_large_channel()
+{
+	const char *big = name("big"), *small = name("small");
+	char user[32];
+
+	for (int i = 0; i < MEMBERS; i++) {
+		const char *member = name((sprintf(user, "member%d", i), user));
+
+		join_channel(big, member);
+		if (i % 100 == 0)
+			join_channel(small, member);
+	}
+
+	// densely interned IDs pack into bitmaps
+	assert(channel_size(big) == MEMBERS);
+	assert(channel_bytes(big) < MEMBERS / 8 + 4 * 8192);
+	assert(shared_members(big, small) == MEMBERS / 100);
+
+	uint64_t visited = 0;
+	for_each_member(big, count, &visited);
+	assert(visited == MEMBERS);
+
+	clear_channel_registry();
+}
+
+int main()
+{
+	test_membership();
+	test_large_channel();
+
+	return EXIT_SUCCESS;
+}
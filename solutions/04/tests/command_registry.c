@@ -0,0 +1,57 @@
+#include "../src/command_registry.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define COMMAND_COUNT 48
+
+
+int main()
+{
+	static char names[COMMAND_COUNT][32];
+	struct command commands[COMMAND_COUNT];
+
+	// dozens of commands, some longer than the old 6 character limit
+	for (int i = 0; i < COMMAND_COUNT; i++) {
+		sprintf(names[i], i % 2 ? "cmd%d" : "a_long_command_%d", i);
+		commands[i] = (struct command) { .name = names[i] };
+	}
+
+	struct command_registry registry;
+	build_command_registry(&registry, commands, COMMAND_COUNT);
+
+	for (int i = 0; i < COMMAND_COUNT; i++)
+		assert(find_command(&registry, names[i], strlen(names[i])) ==
+		       &commands[i]);
+
+	// names only match as a whole
+	assert(find_command(&registry, "cmd1", 3) == NULL);
+	assert(find_command(&registry, "cmd1x", 5) == NULL);
+	assert(find_command(&registry, "login", 5) == NULL);
+	assert(find_command(&registry, "", 0) == NULL);
+
+	free_command_registry(&registry);
+
+	// a name allocated to its exact size, looked up by tokens that hold a
+	// NUL after it; some of them land in its slot, none reads past it
+	char *exact = malloc(5);
+	assert(exact);
+	memcpy(exact, "cmd1", 5);
+
+	struct command single = { .name = exact };
+	build_command_registry(&registry, &single, 1);
+
+	for (char c = 'a'; c <= 'z'; c++) {
+		const char token[] = { 'c', 'm', 'd', '1', '\0', c };
+		assert(find_command(&registry, token, sizeof(token)) == NULL);
+	}
+	assert(find_command(&registry, exact, 4) == &single);
+
+	free_command_registry(&registry);
+	free(exact);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#include "../src/intern.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define NAMES 20000
+#define THREADS 4
+
+
+static void *intern_all(void *arg)
+{
+	const char **out = arg;
+	char name[32];
+
+	for (int i = 0; i < NAMES; i++) {
+		int len = sprintf(name, "user%d", i);
+		out[i] = intern(name, len);
+	}
+
+	return NULL;
+}
+
+int main()
+{
+	uint32_t before = interned_count();
+
+	// equal bytes give the same pointer, spans need no terminator
+	const char *alice = intern("alice", 5);
+	assert(strcmp(alice, "alice") == 0);
+	assert(intern("alice bob", 5) == alice);
+	assert(intern("bob", 3) != alice);
+
+	assert(interned_count() == before + 2);
+	assert(interned_name(interned_id(alice)) == alice);
+
+	// threads interning the same names agree on every pointer
+	static const char *seen[THREADS][NAMES];
+	pthread_t threads[THREADS];
+
+	for (int t = 0; t < THREADS; t++)
+		assert(pthread_create(&threads[t], NULL, intern_all,
+				      seen[t]) == 0);
+	for (int t = 0; t < THREADS; t++)
+		pthread_join(threads[t], NULL);
+
+	assert(interned_count() == before + 2 + NAMES);
+
+	for (int i = 0; i < NAMES; i++) {
+		for (int t = 1; t < THREADS; t++)
+			assert(seen[t][i] == seen[0][i]);
+
+		uint32_t id = interned_id(seen[0][i]);
+		assert(id < interned_count());
+		assert(interned_name(id) == seen[0][i]);
+	}
+
+	return EXIT_SUCCESS;
+}
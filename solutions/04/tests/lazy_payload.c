@@ -0,0 +1,88 @@
+#include "../src/dynamic_dispatch.h"
+#include "../src/lazy_payload.h"
+#include "../src/payload.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char BLOCK[] =
+	"/login alice pass\n"
+	"\n"
+	"@alice @bob hi\n"
+	"/join general\n"
+	"/nonsense\n"
+	"#general hello\n"
+	"global hello\n"
+	"/logout";
+
+#define BLOCK_LINES 7
+
+
+int main()
+{
+	struct lazy_payload_buffer *buf = lazy_new_buffer();
+	assert(lazy_push_payloads(buf, BLOCK, strlen(BLOCK)) == BLOCK_LINES);
+
+	// nothing is parsed before the first access
+	assert(buf->strings.chunks == NULL);
+
+	const enum lazy_kind kinds[BLOCK_LINES] = {
+		LAZY_COMMAND, LAZY_DIRECT_MESSAGE, LAZY_COMMAND, LAZY_COMMAND,
+		LAZY_GROUP_MESSAGE, LAZY_GLOBAL_MESSAGE, LAZY_COMMAND,
+	};
+	for (int i = 0; i < BLOCK_LINES; i++)
+		assert(buf->payloads[i].kind == kinds[i]);
+
+	assert(lazy_count(buf, LAZY_COMMAND) == 4);
+	assert(lazy_count(buf, LAZY_GLOBAL_MESSAGE) == 1);
+	assert(buf->strings.chunks == NULL);
+
+	// fields come out as the eager parser makes them
+	struct payload_buffer *eager = new_buffer();
+	push_payloads_bulk(eager, BLOCK, strlen(BLOCK));
+	assert(eager->len == BLOCK_LINES - 1);
+
+	for (int i = 0, k = 0; i < BLOCK_LINES; i++) {
+		const struct payload *p = lazy_fields(buf, i);
+
+		// the invalid command
+		if (i == 3) {
+			assert(p == NULL);
+			continue;
+		}
+
+		const struct payload *q = &eager->payloads[k++];
+		assert(p->vtable == q->vtable);
+
+		if (p->vtable == &message_vtable) {
+			assert(strcmp(p->data.message.content,
+				      q->data.message.content) == 0);
+			assert(p->data.message.receiver_count ==
+			       q->data.message.receiver_count);
+		}
+
+		const char *name;
+		for (int n = 0; p->vtable->name &&
+		     (name = p->vtable->name(p, n)); n++)
+			assert(strcmp(name, q->vtable->name(q, n)) == 0);
+	}
+
+	// parsed once
+	assert(lazy_fields(buf, 0) == lazy_fields(buf, 0));
+	assert(strcmp(lazy_fields(buf, 0)->data.command_login.password,
+		      "pass") == 0);
+
+	destroy(eager);
+
+	// pushing appends, and lines of a later block are counted too
+	assert(lazy_push_payloads(buf, "\n\n@bob\n", 7) == 1);
+	assert(buf->len == BLOCK_LINES + 1);
+	assert(buf->payloads[BLOCK_LINES].len == 4);
+	assert(lazy_push_payloads(buf, "", 0) == 0);
+
+	lazy_destroy(buf);
+
+	return EXIT_SUCCESS;
+}
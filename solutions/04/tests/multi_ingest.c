@@ -0,0 +1,168 @@
+#include "../src/dynamic_dispatch.h"
+#include "../src/multi_ingest.h"
+#include "../src/payload.h"
+#include "../src/payload_file.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define FILES 6
+#define BIG_LINES 60000
+
+
+static char paths[FILES][32];
+static char *texts[FILES];
+static size_t lens[FILES];
+
+
+static void assert_same_payloads(const struct payload_buffer *a,
+				 const struct payload_buffer *b)
+{
+	assert(a->len == b->len);
+
+	for (int i = 0; i < a->len; i++) {
+		const struct payload *p = &a->payloads[i];
+		const struct payload *q = &b->payloads[i];
+
+		assert(p->vtable == q->vtable);
+
+		if (p->vtable == &message_vtable)
+			assert(strcmp(p->data.message.content,
+				      q->data.message.content) == 0);
+
+		if (p->vtable->name == NULL)
+			continue;
+
+		const char *name;
+		for (int k = 0; (name = p->vtable->name(p, k)); k++)
+			assert(strcmp(name, q->vtable->name(q, k)) == 0);
+	}
+}
+
+static void write_file(int i, size_t cap)
+{
+	texts[i] = malloc(cap);
+	assert(texts[i]);
+	lens[i] = 0;
+
+	snprintf(paths[i], sizeof(paths[i]), "/tmp/multi_ingestXXXXXX");
+	int fd = mkstemp(paths[i]);
+	assert(fd >= 0);
+	close(fd);
+}
+
+static void flush_file(int i)
+{
+	FILE *f = fopen(paths[i], "w");
+	assert(f);
+	assert(fwrite(texts[i], 1, lens[i], f) == lens[i]);
+	fclose(f);
+}
+
+int main()
+{
+	// several blocks long, so lines are cut between reads
+	write_file(0, BIG_LINES * 48);
+	for (int k = 0; k < BIG_LINES; k++)
+		lens[0] += sprintf(texts[0] + lens[0],
+				   k % 3 ? "@user%d @user%d message %d\n" :
+				   "#chan%d %d text\n", k, k + 1, k);
+
+	write_file(1, 64);
+	lens[1] = sprintf(texts[1], "/login alice pw\n\n/join general\n");
+
+	// empty
+	write_file(2, 1);
+
+	// no trailing newline
+	write_file(3, 64);
+	lens[3] = sprintf(texts[3], "global hello\n#general last");
+
+	write_file(4, 64);
+	lens[4] = sprintf(texts[4], "/logout\n");
+
+	write_file(5, 64);
+	lens[5] = sprintf(texts[5], "@bob after\n");
+
+	for (int i = 0; i < FILES; i++)
+		flush_file(i);
+
+	// as if the files had been concatenated
+	size_t total = 0;
+	for (int i = 0; i < FILES; i++)
+		total += lens[i] + 1;
+
+	char *all = malloc(total);
+	assert(all);
+
+	size_t len = 0;
+	for (int i = 0; i < FILES; i++) {
+		memcpy(all + len, texts[i], lens[i]);
+		len += lens[i];
+
+		if (lens[i] > 0 && texts[i][lens[i] - 1] != '\n')
+			all[len++] = '\n';
+	}
+
+	struct payload_buffer *expected = new_buffer();
+	push_payloads_bulk(expected, all, len);
+	assert(expected->len == BIG_LINES + 6);
+
+	const char *list[FILES];
+	for (int i = 0; i < FILES; i++)
+		list[i] = paths[i];
+
+	for (int depth = 1; depth <= 8; depth *= 2) {
+		struct payload_buffer *buf = new_buffer();
+		assert(push_payload_files_threads(buf, list, FILES, depth));
+		assert_same_payloads(expected, buf);
+		destroy(buf);
+
+		// the same through io_uring, or its fallback
+		buf = new_buffer();
+		assert(push_payload_files_uring(buf, list, FILES, depth));
+		assert_same_payloads(expected, buf);
+		destroy(buf);
+	}
+
+	// a depth beyond what a ring can hold still reads every file
+	struct payload_buffer *buf = new_buffer();
+	assert(push_payload_files_uring(buf, list, FILES, 100000));
+	assert_same_payloads(expected, buf);
+	destroy(buf);
+
+	// appended behind what is there already
+	buf = new_buffer();
+	assert(push_payload_files(buf, list + 1, 1, 0));
+	assert(push_payload_files(buf, list + 3, 3, 0));
+	assert(buf->len == 6);
+	assert(buf->payloads[2].vtable == &message_vtable);
+	assert(strcmp(buf->payloads[3].data.message.content, "last") == 0);
+
+	assert(push_payload_files(buf, list, 0, 0));
+	assert(buf->len == 6);
+
+	// a missing file leaves the buffer unchanged
+	list[4] = "/nonexistent/payloads.txt";
+
+	assert(!push_payload_files_threads(buf, list, FILES, 4));
+	assert(buf->len == 6);
+
+	assert(!push_payload_files_uring(buf, list, FILES, 4));
+	assert(buf->len == 6);
+
+	destroy(buf);
+	destroy(expected);
+
+	for (int i = 0; i < FILES; i++) {
+		remove(paths[i]);
+		free(texts[i]);
+	}
+	free(all);
+
+	return EXIT_SUCCESS;
+}
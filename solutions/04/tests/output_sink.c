@@ -0,0 +1,85 @@
+#include "../src/output_sink.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define SMALL_CAP 64
+#define LINES 1000
+#define BIG 1000
+
+
+/* writes a mix of small, buffer-sized and oversized output to sink, and the
+ * same bytes to expected */
+static size_t write_mix(struct output_sink *sink, char *expected)
+{
+	size_t len = 0;
+	char big[BIG + 1];
+
+	memset(big, 'b', BIG);
+	big[BIG] = '\0';
+
+	for (int i = 0; i < LINES; i++) {
+		sink_printf(sink, "line %d of %d\n", i, LINES);
+		len += sprintf(expected + len, "line %d of %d\n", i, LINES);
+
+		if (i % 100 == 0) {
+			sink_write(sink, big, BIG);
+			memcpy(expected + len, big, BIG);
+			len += BIG;
+
+			sink_printf(sink, "<%s>\n", big);
+			len += sprintf(expected + len, "<%s>\n", big);
+		}
+
+		if (i % 10 == 0) {
+			sink_write(sink, "x", 1);
+			expected[len++] = 'x';
+		}
+	}
+
+	return len;
+}
+
+int main()
+{
+	char *expected = malloc(LINES * 64 + 20 * (2 * BIG + 4));
+	char *actual = malloc(LINES * 64 + 20 * (2 * BIG + 4));
+	assert(expected && actual);
+
+	for (int async = 0; async <= 1; async++) {
+		char path[] = "/tmp/output_sink_testXXXXXX";
+		int fd = mkstemp(path);
+		assert(fd >= 0);
+
+		struct output_sink sink;
+		sink_open(&sink, fd, SMALL_CAP, async);
+		size_t len = write_mix(&sink, expected);
+
+		// everything is on disk after a flush
+		sink_flush(&sink);
+		assert((size_t) lseek(fd, 0, SEEK_CUR) == len);
+
+		sink_write(&sink, "end\n", 4);
+		memcpy(expected + len, "end\n", 4);
+		len += 4;
+
+		sink_close(&sink);
+		assert(sink.buf == NULL);
+
+		assert(pread(fd, actual, len + 1, 0) == (ssize_t) len);
+		assert(memcmp(actual, expected, len) == 0);
+
+		close(fd);
+		remove(path);
+	}
+
+	free(actual);
+	free(expected);
+
+	return EXIT_SUCCESS;
+}
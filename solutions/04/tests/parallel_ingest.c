@@ -0,0 +1,110 @@
+#include "../src/dynamic_dispatch.h"
+#include "../src/parallel_ingest.h"
+#include "../src/payload.h"
+#include "../src/payload_file.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define LINES 20000
+
+
+static void assert_same_payloads(const struct payload_buffer *a,
+				 const struct payload_buffer *b)
+{
+	assert(a->len == b->len);
+
+	for (int i = 0; i < a->len; i++) {
+		const struct payload *p = &a->payloads[i];
+		const struct payload *q = &b->payloads[i];
+
+		assert(p->vtable == q->vtable);
+
+		if (p->vtable == &message_vtable) {
+			assert(strcmp(p->data.message.content,
+				      q->data.message.content) == 0);
+			assert(p->data.message.receiver_count ==
+			       q->data.message.receiver_count);
+		}
+
+		if (p->vtable->name == NULL)
+			continue;
+
+		const char *name;
+		for (int k = 0; (name = p->vtable->name(p, k)); k++)
+			assert(strcmp(name, q->vtable->name(q, k)) == 0);
+	}
+}
+
+int main()
+{
+	char *text = malloc(LINES * 64);
+	assert(text);
+
+	size_t len = 0;
+	for (int i = 0; i < LINES; i++) {
+		switch (i % 6) {
+		case 0:
+			len += sprintf(text + len, "/login user%d pw\n", i);
+			break;
+		case 1:
+			len += sprintf(text + len, "@user%d @user%d hi %d\n",
+				       i, i - 1, i);
+			break;
+		case 2:
+			len += sprintf(text + len, "#chan%d text %d\n", i, i);
+			break;
+		case 3:
+			len += sprintf(text + len, "\n/join chan%d\n", i);
+			break;
+		case 4:
+			len += sprintf(text + len, "/logout\n");
+			break;
+		default:
+			len += sprintf(text + len, "plain %d\n", i);
+		}
+	}
+
+	struct payload_file file = { .data = text, .len = len };
+
+	struct payload_buffer *expected = new_buffer();
+	push_payloads_parallel(expected, &file, 1);
+	assert(expected->len == LINES);
+
+	// the result does not depend on the number of workers
+	for (int workers = 2; workers <= 64; workers *= 2) {
+		struct payload_buffer *buf = new_buffer();
+		push_payloads_parallel(buf, &file, workers);
+
+		assert_same_payloads(expected, buf);
+		destroy(buf);
+	}
+
+	// parsed payloads are appended to what is already there
+	struct payload_buffer *twice = new_buffer();
+	push_payloads_parallel(twice, &file, 3);
+	push_payloads_parallel(twice, &file, 0);
+	assert(twice->len == 2 * LINES);
+	assert(strcmp(twice->payloads[LINES + 1].data.message.content,
+		      "hi 1") == 0);
+	destroy(twice);
+
+	// more workers than lines, and no lines at all
+	struct payload_file few = { .data = "/logout\nhi\n", .len = 11 };
+	struct payload_buffer *buf = new_buffer();
+	push_payloads_parallel(buf, &few, 8);
+	assert(buf->len == 2);
+
+	struct payload_file empty = { .data = NULL, .len = 0 };
+	push_payloads_parallel(buf, &empty, 8);
+	assert(buf->len == 2);
+	destroy(buf);
+
+	destroy(expected);
+	free(text);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+#include "../src/arena.h"
+#include "../src/payload.h"
+#include "../src/structural_index.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* parses a single line into p, its strings going to strings */
+static void parse_line(struct payload *p, const char *text,
+		       struct arena *strings)
+{
+	struct structural_index idx = { 0 };
+	struct payload_line line;
+
+	build_structural_index(&idx, text, strlen(text));
+	assert(idx.line_count == 1);
+	indexed_line(&idx, text, 0, &line);
+	assert(parse_payload(p, &line, strings));
+	free_structural_index(&idx);
+}
+
+static void test_inline_receivers()
+{
+	struct arena strings = { .chunks = NULL };
+	struct payload p;
+
+	// a global message is a single receiver without a name
+	parse_line(&p, "hello", &strings);
+	assert(p.vtable == &message_vtable);
+	assert(p.data.message.receiver_count == 1);
+	assert(message_receivers(&p.data)[0].vtable ==
+	       &global_message_vtable);
+	assert(p.vtable->name(&p, 0) == NULL);
+
+	parse_line(&p, "@bob hi", &strings);
+	assert(p.data.message.receiver_count == 1);
+	assert(strcmp(p.vtable->name(&p, 0), "bob") == 0);
+	assert(p.vtable->name(&p, 1) == NULL);
+
+	// only the content went to the arena, the receiver is inline
+	assert(message_receivers(&p.data) == p.data.message.inline_receivers);
+
+	// and moves with the payload
+	struct payload copy;
+	memcpy(&copy, &p, sizeof(p));
+	memset(&p, 0, sizeof(p));
+	assert(message_receivers(&copy.data)[0].vtable ==
+	       &direct_message_vtable);
+	assert(strcmp(copy.vtable->name(&copy, 0), "bob") == 0);
+
+	arena_release(&strings);
+}
+
+static void test_spilled_receivers()
+{
+	struct arena strings = { .chunks = NULL };
+	struct payload p;
+
+	static_assert(MESSAGE_INLINE_RECEIVERS < 5, "the receivers must spill");
+
+	parse_line(&p, "@a #b @c #d @e spill", &strings);
+	assert(p.data.message.receiver_count == 5);
+	assert(message_receivers(&p.data) == p.data.message.receivers);
+
+	const char *names[] = { "a", "b", "c", "d", "e" };
+	for (int i = 0; i < 5; i++) {
+		assert(strcmp(p.vtable->name(&p, i), names[i]) == 0);
+		assert(message_receivers(&p.data)[i].vtable ==
+		       (i % 2 ? &group_message_vtable :
+			&direct_message_vtable));
+	}
+	assert(strcmp(p.data.message.content, "spill") == 0);
+
+	arena_release(&strings);
+}
+
+int main()
+{
+	test_inline_receivers();
+	test_spilled_receivers();
+
+	return EXIT_SUCCESS;
+}
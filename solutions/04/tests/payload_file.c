@@ -0,0 +1,75 @@
+#include "../src/payload_file.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define LONG_LINE_LEN 4096
+
+
+int main()
+{
+	char path[] = "/tmp/payload_file_testXXXXXX";
+	FILE *tmp = fdopen(mkstemp(path), "w");
+	assert(tmp);
+
+	// longer than the old 1024 byte fgets buffer, and no trailing newline
+	// on the last line
+	fputs("/login alice pass123\n\n", tmp);
+	for (int i = 0; i < LONG_LINE_LEN; i++)
+		fputc('x', tmp);
+	fputs("\n@bob hi", tmp);
+	fclose(tmp);
+
+	struct payload_file file;
+	assert(map_payload_file(&file, path));
+
+	const char *line;
+	size_t line_len, cursor = 0;
+
+	assert(next_line(&file, &cursor, &line, &line_len));
+	assert(line_len == 20 && memcmp(line, "/login alice pass123", 20) == 0);
+
+	assert(next_line(&file, &cursor, &line, &line_len));
+	assert(line_len == 0);
+
+	assert(next_line(&file, &cursor, &line, &line_len));
+	assert(line_len == LONG_LINE_LEN && line[LONG_LINE_LEN - 1] == 'x');
+
+	assert(next_line(&file, &cursor, &line, &line_len));
+	assert(line_len == 7 && memcmp(line, "@bob hi", 7) == 0);
+
+	assert(!next_line(&file, &cursor, &line, &line_len));
+
+	// chunks end after a newline and cover the file in order
+	struct payload_file chunks[10];
+	assert(split_payload_file(&file, 2, chunks) == 2);
+	assert(chunks[0].data == file.data);
+	assert(chunks[0].data[chunks[0].len - 1] == '\n');
+	assert(chunks[1].data == chunks[0].data + chunks[0].len);
+	assert(chunks[0].len + chunks[1].len == file.len);
+
+	// no more chunks than lines
+	struct payload_file text = { .data = "a\nbb\nccc\n", .len = 9 };
+	assert(split_payload_file(&text, 10, chunks) == 3);
+	assert(chunks[0].len == 2 && chunks[1].len == 3 && chunks[2].len == 4);
+
+	assert(split_payload_file(&text, 1, chunks) == 1);
+	assert(chunks[0].len == 9);
+
+	// empty lines count, a missing trailing newline does not matter
+	assert(count_lines(&file) == 4);
+	assert(count_lines(&text) == 3);
+	assert(count_lines(&(struct payload_file) { .data = "a\nb",
+						    .len = 3 }) == 2);
+	assert(count_lines(&(struct payload_file) { .data = NULL }) == 0);
+
+	unmap_payload_file(&file);
+	remove(path);
+
+	assert(!map_payload_file(&file, path));
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+#include "../src/dynamic_dispatch.h"
+#include "../src/parallel_ingest.h"
+#include "../src/payload.h"
+#include "../src/payload_file.h"
+#include "../src/payload_log.h"
+
+#include <assert.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define LINES 20000
+#define SEGMENT_BYTES (64 << 10)
+
+
+static char dir[] = "/tmp/payload_log_testXXXXXX";
+
+
+/* the k-th generated line carries k in its content or names */
+static char *generate(size_t *len)
+{
+	char *text = malloc(LINES * 64);
+	assert(text);
+
+	*len = 0;
+	for (int i = 0; i < LINES; i++)
+		*len += sprintf(text + *len, i % 3 == 0 ? "/login u%d pw\n" :
+				i % 3 == 1 ? "@u%d msg\n" : "global %d\n", i);
+
+	return text;
+}
+
+static void assert_payload(const struct payload *p, int k)
+{
+	char expected[32];
+
+	switch (k % 3) {
+	case 0:
+		sprintf(expected, "u%d", k);
+		assert(p->vtable == &command_login_vtable);
+		assert(strcmp(p->data.command_login.username, expected) == 0);
+		break;
+	case 1:
+		sprintf(expected, "u%d", k);
+		assert(p->vtable == &message_vtable);
+		assert(strcmp(p->vtable->name(p, 0), expected) == 0);
+		break;
+	default:
+		sprintf(expected, "%d", k);
+		assert(p->vtable == &message_vtable);
+		assert(strcmp(p->data.message.content + 7, expected) == 0);
+	}
+}
+
+static void assert_replay(uint64_t from, int expected_len)
+{
+	struct payload_buffer *buf = new_buffer();
+
+	assert(replay_payload_log(buf, dir, from));
+	assert(buf->len == expected_len);
+
+	for (int i = 0; i < buf->len; i++)
+		assert_payload(&buf->payloads[i], from + i);
+
+	destroy(buf);
+}
+
+static size_t segment_count()
+{
+	DIR *d = opendir(dir);
+	size_t count = 0;
+
+	for (struct dirent *entry; (entry = readdir(d)) != NULL;)
+		count += strstr(entry->d_name, ".log") != NULL;
+
+	closedir(d);
+	return count;
+}
+
+/* cuts the last bytes off the newest segment, like a crash mid-write */
+static void tear_last_segment()
+{
+	DIR *d = opendir(dir);
+	char last[64] = "";
+
+	for (struct dirent *entry; (entry = readdir(d)) != NULL;)
+		if (strstr(entry->d_name, ".log") &&
+		    strcmp(entry->d_name, last) > 0)
+			strcpy(last, entry->d_name);
+	closedir(d);
+
+	char path[512];
+	sprintf(path, "%s/%s", dir, last);
+
+	FILE *f = fopen(path, "r+");
+	fseek(f, 0, SEEK_END);
+	long len = ftell(f);
+	fclose(f);
+
+	assert(truncate(path, len - 3) == 0);
+}
+
+static void remove_log()
+{
+	DIR *d = opendir(dir);
+	char path[512];
+
+	for (struct dirent *entry; (entry = readdir(d)) != NULL;) {
+		if (entry->d_name[0] == '.')
+			continue;
+
+		sprintf(path, "%s/%s", dir, entry->d_name);
+		unlink(path);
+	}
+
+	closedir(d);
+	rmdir(dir);
+}
+
+int main()
+{
+	assert(mkdtemp(dir));
+
+	size_t len;
+	char *text = generate(&len);
+	struct payload_file file = { .data = text, .len = len };
+
+	// every payload read goes to the log, in small segments
+	struct payload_log log;
+	assert(open_payload_log(&log, dir, SEGMENT_BYTES));
+
+	struct payload_buffer *buf = new_buffer();
+	buf->log = &log;
+	push_payloads_parallel(buf, &file, 4);
+	assert(buf->len == LINES);
+	assert(log.next_seq == LINES);
+	close_payload_log(&log);
+	destroy(buf);
+
+	assert(segment_count() > 4);
+
+	// any starting point, including segment boundaries and the end
+	assert_replay(0, LINES);
+	for (int from = 1; from < LINES; from += 997)
+		assert_replay(from, LINES - from);
+	assert_replay(LINES - 1, 1);
+	assert_replay(LINES, 0);
+	assert_replay(LINES * 2, 0);
+
+	// a torn record ends the log, which continues after the last whole one
+	tear_last_segment();
+	assert_replay(0, LINES - 1);
+
+	assert(open_payload_log(&log, dir, SEGMENT_BYTES));
+	assert(log.next_seq == LINES - 1);
+
+	buf = new_buffer();
+	buf->log = &log;
+	push_payloads_parallel(buf, &file, 1);
+	close_payload_log(&log);
+	destroy(buf);
+
+	// the torn record's number is taken by the first new payload
+	struct payload_buffer *replayed = new_buffer();
+	assert(replay_payload_log(replayed, dir, LINES - 2));
+	assert(replayed->len == 1 + LINES);
+	assert_payload(&replayed->payloads[0], LINES - 2);
+	for (int i = 1; i < replayed->len; i++)
+		assert_payload(&replayed->payloads[i], i - 1);
+	destroy(replayed);
+
+	struct payload_buffer *missing = new_buffer();
+	assert(!replay_payload_log(missing, "/nonexistent/payload_log", 0));
+	destroy(missing);
+
+	remove_log();
+	free(text);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+#include "../src/roaring.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define SPAN (1 << 18)
+
+
+/* compares r against the reference set of IDs below SPAN */
+static void assert_same(const struct roaring *r, const bool *reference)
+{
+	struct roaring_cursor cursor = { 0 };
+	uint32_t x, expected = 0;
+	uint64_t n = 0;
+
+	while (roaring_next(r, &cursor, &x)) {
+		// ascending, each ID once
+		assert(n == 0 || x > expected);
+		assert(x < SPAN && reference[x]);
+		expected = x;
+		n++;
+	}
+
+	uint64_t count = 0;
+	for (uint32_t i = 0; i < SPAN; i++)
+		count += reference[i];
+
+	assert(n == count);
+	assert(roaring_cardinality(r) == count);
+}
+
+static void test_add_remove()
+{
+	static bool reference[SPAN];
+	struct roaring r = { .containers = NULL };
+
+	srand(1);
+
+	// sparse in some chunks, dense enough for bitmaps in others
+	for (int i = 0; i < 60000; i++) {
+		uint32_t x = i % 20 ? rand() % 8000 : rand() % SPAN;
+
+		assert(roaring_add(&r, x) == !reference[x]);
+		reference[x] = true;
+	}
+	assert(r.containers[0].is_bitmap);
+	assert(!r.containers[r.len - 1].is_bitmap);
+	assert_same(&r, reference);
+
+	for (uint32_t x = 0; x < SPAN; x++)
+		assert(roaring_contains(&r, x) == reference[x]);
+
+	// the dense chunk turns back into an array, emptied ones disappear
+	for (uint32_t x = 0; x < SPAN; x++) {
+		if (x % 4 != 0 || x >= 3 * (SPAN / 4)) {
+			assert(roaring_remove(&r, x) == reference[x]);
+			reference[x] = false;
+		}
+	}
+	assert(!roaring_remove(&r, 1));
+	assert_same(&r, reference);
+	assert(!r.containers[0].is_bitmap);
+	assert(r.len == 3);
+
+	roaring_free(&r);
+	assert(roaring_cardinality(&r) == 0);
+	assert(!roaring_contains(&r, 5));
+
+	struct roaring_cursor cursor = { 0 };
+	uint32_t x;
+	assert(!roaring_next(&r, &cursor, &x));
+}
+
+static void test_threshold()
+{
+	struct roaring r = { .containers = NULL };
+
+	for (uint32_t x = 0; x < ROARING_ARRAY_MAX; x++)
+		roaring_add(&r, 2 * x);
+	assert(!r.containers[0].is_bitmap);
+
+	roaring_add(&r, 1);
+	assert(r.containers[0].is_bitmap);
+
+	// going back and forth across the threshold keeps the bitmap
+	for (int i = 0; i < 100; i++) {
+		assert(roaring_remove(&r, 1));
+		assert(r.containers[0].is_bitmap);
+		assert(roaring_add(&r, 1));
+		assert(r.containers[0].is_bitmap);
+	}
+
+	// until it drops below the lower one
+	uint32_t x = 0;
+	while (roaring_cardinality(&r) > ROARING_ARRAY_MIN) {
+		assert(roaring_remove(&r, x));
+		x += 2;
+	}
+	assert(r.containers[0].is_bitmap);
+
+	assert(roaring_remove(&r, x));
+	assert(!r.containers[0].is_bitmap);
+	assert(roaring_cardinality(&r) == ROARING_ARRAY_MIN - 1);
+	assert(roaring_contains(&r, 1));
+	assert(!roaring_contains(&r, x));
+
+	roaring_free(&r);
+}
+
+static void test_and()
+{
+	static bool in_a[SPAN], in_b[SPAN], in_both[SPAN];
+	struct roaring a = { .containers = NULL };
+	struct roaring b = { .containers = NULL };
+	struct roaring both = { .containers = NULL };
+
+	// every pairing of array and bitmap containers, and a few tiny sets
+	// against large ones
+	for (uint32_t x = 0; x < SPAN; x++) {
+		uint32_t chunk = x >> 16;
+
+		in_a[x] = chunk % 2 ? x % 3 == 0 : x % 29 == 0;
+		in_b[x] = chunk < 2 ? x % 5 == 0 : x % 997 == 0;
+		in_both[x] = in_a[x] && in_b[x];
+
+		if (in_a[x])
+			roaring_add(&a, x);
+		if (in_b[x])
+			roaring_add(&b, x);
+	}
+
+	roaring_and(&both, &a, &b);
+	assert_same(&both, in_both);
+	assert(roaring_and_cardinality(&a, &b) == roaring_cardinality(&both));
+	assert(roaring_and_cardinality(&b, &a) == roaring_cardinality(&both));
+
+	// reusing the output replaces its contents
+	roaring_and(&both, &b, &b);
+	assert_same(&both, in_b);
+
+	roaring_free(&a);
+	roaring_free(&b);
+	roaring_free(&both);
+}
+
+static void test_size()
+{
+	struct roaring r = { .containers = NULL };
+
+	// a dense run of 100k IDs takes about a bit each
+	for (uint32_t x = 0; x < 100000; x++)
+		roaring_add(&r, 1000000 + x);
+
+	assert(roaring_cardinality(&r) == 100000);
+	assert(roaring_bytes(&r) < 100000 / 8 + 2 * 8192);
+
+	roaring_free(&r);
+}
+
+int main()
+{
+	test_add_remove();
+	test_threshold();
+	test_and();
+	test_size();
+
+	return EXIT_SUCCESS;
+}
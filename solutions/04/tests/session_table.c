@@ -0,0 +1,107 @@
+#include "../src/intern.h"
+#include "../src/session_table.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define USERS 200000
+#define THREADS 4
+
+
+static const char *users[USERS];
+
+
+static void test_sessions()
+{
+	const char *alice = intern("alice", 5), *bob = intern("bob", 3);
+
+	assert(!is_online(alice));
+	assert(!close_session(alice));
+
+	open_session(alice);
+	open_session(alice);
+	open_session(bob);
+	assert(is_online(alice) && is_online(bob));
+	assert(online_count() == 2);
+
+	// online until the last session closes
+	assert(close_session(alice));
+	assert(is_online(alice));
+	assert(close_session(alice));
+	assert(!is_online(alice));
+	assert(!close_session(alice));
+	assert(online_count() == 1);
+
+	clear_session_table();
+	assert(!is_online(bob));
+	assert(online_count() == 0);
+}
+
+/* every session of its users opened and closed in a random order against a
+ * reference, probing clusters shift back on every removal */
+static void *churn(void *arg)
+{
+	int part = (int) (size_t) arg;
+	int from = part * (USERS / THREADS), to = from + USERS / THREADS;
+	unsigned seed = part;
+	char *online = calloc(USERS / THREADS, 1);
+	assert(online);
+
+	for (int step = 0; step < USERS * 2; step++) {
+		int i = from + rand_r(&seed) % (to - from);
+
+		if (online[i - from]) {
+			assert(close_session(users[i]));
+			online[i - from] = 0;
+		} else {
+			open_session(users[i]);
+			online[i - from] = 1;
+		}
+	}
+
+	for (int i = from; i < to; i++)
+		assert(is_online(users[i]) == online[i - from]);
+
+	free(online);
+	return NULL;
+}
+
+static void test_churn()
+{
+	char name[32];
+
+	for (int i = 0; i < USERS; i++)
+		users[i] = intern(name, sprintf(name, "user%d", i));
+
+	pthread_t threads[THREADS];
+	for (int t = 0; t < THREADS; t++)
+		pthread_create(&threads[t], NULL, churn, (void *) (size_t) t);
+	for (int t = 0; t < THREADS; t++)
+		pthread_join(threads[t], NULL);
+
+	// close what is left, the table must end up empty
+	for (int i = 0; i < USERS; i++)
+		if (is_online(users[i]))
+			assert(close_session(users[i]));
+	assert(online_count() == 0);
+
+	// slots are 8 bytes, tables at most 3/4 full
+	for (int i = 0; i < USERS; i++)
+		open_session(users[i]);
+	assert(online_count() == USERS);
+	assert(session_table_bytes() <= (size_t) USERS * 8 * 8 / 3);
+
+	clear_session_table();
+}
+
+int main()
+{
+	test_sessions();
+	test_churn();
+
+	return EXIT_SUCCESS;
+}
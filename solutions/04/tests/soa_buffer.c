@@ -0,0 +1,79 @@
+#include "../src/dynamic_dispatch.h"
+#include "../src/payload.h"
+#include "../src/soa_buffer.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char CORPUS[] =
+	"/login alice pass\n"
+	"@alice hi\n"
+	"/join general\n"
+	"/bogus\n"
+	"#general #random hello\n"
+	"/logout\n"
+	"global hello\n";
+
+
+int main()
+{
+	struct payload_buffer *aos = new_buffer();
+	struct soa_payload_buffer *soa = soa_new_buffer();
+
+	struct structural_index idx = { .marks = NULL };
+	build_structural_index(&idx, CORPUS, strlen(CORPUS));
+
+	for (size_t i = 0; i < idx.line_count; i++) {
+		struct payload_line line;
+		indexed_line(&idx, CORPUS, i, &line);
+
+		push_payload(aos, &line);
+		soa_push_payload(soa, &line);
+	}
+
+	free_structural_index(&idx);
+
+	assert(soa->len == aos->len && soa->len == 6);
+	assert(soa->column_count == 4);
+	assert(soa_count(soa, &message_vtable) == 3);
+	assert(soa_count(soa, &command_logout_vtable) == 1);
+
+	// every payload is found in its column, in arrival order
+	int rows[4] = { 0 };
+
+	for (int i = 0; i < aos->len; i++) {
+		const struct payload *p = &aos->payloads[i];
+		assert(soa->vtables[i] == p->vtable);
+
+		int c;
+		for (c = 0; soa->columns[c].vtable != p->vtable; c++);
+
+		size_t size = p->vtable->data_size;
+		const union payload_data *data = (const void *) (
+			soa->columns[c].rows + rows[c]++ * size);
+
+		if (p->vtable == &command_login_vtable)
+			assert(strcmp(data->command_login.password,
+				      p->data.command_login.password) == 0);
+		else if (p->vtable == &message_vtable)
+			assert(strcmp(data->message.content,
+				      p->data.message.content) == 0 &&
+			       data->message.receiver_count ==
+			       p->data.message.receiver_count);
+	}
+
+	// logout takes up no row at all
+	for (int c = 0; c < soa->column_count; c++)
+		if (soa->columns[c].vtable == &command_logout_vtable)
+			assert(soa->columns[c].len == 0);
+
+	for (int i = 0; i < soa->len; i++)
+		soa_process_next(soa);
+
+	soa_destroy(soa);
+	destroy(aos);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#include "../src/spsc_ring.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+
+
+#define ITEMS 1000000
+
+
+static void *produce(void *arg)
+{
+	struct spsc_ring *ring = arg;
+
+	// items are offset by one, NULL would be indistinguishable from 0
+	for (uintptr_t i = 1; i <= ITEMS; i++)
+		spsc_push_wait(ring, (void *) i);
+
+	return NULL;
+}
+
+int main()
+{
+	struct spsc_ring ring;
+
+	// capacity is rounded up to a power of 2
+	spsc_init(&ring, 3);
+	assert(ring.mask == 3);
+
+	void *item;
+	assert(!spsc_pop(&ring, &item));
+
+	for (uintptr_t i = 1; i <= 4; i++)
+		assert(spsc_push(&ring, (void *) i));
+	assert(!spsc_push(&ring, (void *) 5));
+
+	assert(spsc_pop(&ring, &item) && item == (void *) 1);
+	assert(spsc_push(&ring, (void *) 5));
+
+	for (uintptr_t i = 2; i <= 5; i++)
+		assert(spsc_pop(&ring, &item) && item == (void *) i);
+	assert(!spsc_pop(&ring, &item));
+
+	spsc_free(&ring);
+
+	// items arrive in order across threads, through a ring that wraps
+	// around many times
+	spsc_init(&ring, 64);
+
+	pthread_t producer;
+	assert(pthread_create(&producer, NULL, produce, &ring) == 0);
+
+	for (uintptr_t i = 1; i <= ITEMS; i++)
+		assert(spsc_pop_wait(&ring) == (void *) i);
+
+	pthread_join(producer, NULL);
+	assert(!spsc_pop(&ring, &item));
+
+	spsc_free(&ring);
+
+	return 0;
+}
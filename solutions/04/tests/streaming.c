@@ -0,0 +1,189 @@
+#include "../src/dynamic_dispatch.h"
+#include "../src/output_sink.h"
+#include "../src/payload.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define HIGH_WATER 8
+#define PAYLOAD_COUNT 1000
+
+
+static char text[32];
+static struct structural_index idx = { .marks = NULL };
+
+static bool push_numbered(struct payload_buffer *buf, int i)
+{
+	int len = snprintf(text, sizeof(text), "@alice m%d", i);
+
+	struct payload_line line;
+	build_structural_index(&idx, text, len);
+	indexed_line(&idx, text, 0, &line);
+
+	return push_payload(buf, &line);
+}
+
+/* checks the next payload is number i and skips it, processing would print */
+static void consume(struct payload_buffer *buf, int i)
+{
+	char expected[32];
+	snprintf(expected, sizeof(expected), "m%d", i);
+
+	assert(buf->process_base < buf->len);
+
+	const struct payload *p = buffer_payload(buf, buf->process_base);
+	assert(p->vtable == &message_vtable);
+	assert(strcmp(p->data.message.content, expected) == 0);
+
+	buf->process_base++;
+}
+
+/* streams lines with an invalid command among them through an async sink,
+ * as main --stream does, and checks the report comes out between the
+ * payloads around it */
+static void check_report_order()
+{
+	static const char *const lines[] = {
+		"/login alice pw", "/bogus", "global hi",
+	};
+
+	char path[] = "/tmp/streaming_testXXXXXX";
+	int fd = mkstemp(path);
+	assert(fd >= 0);
+
+	struct output_sink out;
+	sink_open(&out, fd, 0, true);
+	payload_output = &out;
+
+	struct payload_buffer *buf = new_buffer();
+	stream_buffer(buf, 1);
+
+	for (size_t i = 0; i < sizeof(lines) / sizeof(*lines); i++) {
+		struct payload_line line;
+		build_structural_index(&idx, lines[i], strlen(lines[i]));
+		indexed_line(&idx, lines[i], 0, &line);
+
+		if (buffer_full(buf))
+			process_next(buf);
+
+		push_payload(buf, &line);
+	}
+
+	while (buf->process_base < buf->len)
+		process_next(buf);
+
+	payload_output = NULL;
+	sink_close(&out);
+	destroy(buf);
+
+	char text[512];
+	ssize_t len = pread(fd, text, sizeof(text) - 1, 0);
+	assert(len > 0);
+	text[len] = '\0';
+
+	close(fd);
+	remove(path);
+
+	const char *login = strstr(text, "Command: login");
+	const char *report = strstr(text, "Ignoring invalid command bogus");
+	const char *global = strstr(text, "Global message: global hi");
+
+	assert(login && report && global);
+	assert(login < report && report < global);
+}
+
+int main()
+{
+	struct payload_buffer *buf = new_buffer();
+	stream_buffer(buf, HIGH_WATER);
+
+	int pushed = 0, consumed = 0;
+
+	// consume only part of each full window, so unprocessed payloads
+	// outlive the compaction that keeps their strings and the ring wraps
+	while (pushed < PAYLOAD_COUNT) {
+		if (buffer_full(buf)) {
+			// refused without parsing anything
+			struct arena_chunk *chunks = buf->strings.chunks;
+			bool accepted = push_numbered(buf, -1);
+			assert(!accepted);
+			assert(buf->strings.chunks == chunks);
+			assert(buf->dropped + buf->len == pushed);
+
+			for (int i = 0; i < 3; i++)
+				consume(buf, consumed++);
+		}
+
+		push_numbered(buf, pushed++);
+
+		assert(buf->cap == HIGH_WATER);
+		assert(buf->len - buf->process_base <= HIGH_WATER);
+		assert(buf->dropped + buf->len == pushed);
+
+		// a generation only survives while it has unprocessed payloads,
+		// which all fit in one window
+		assert(buf->generation_count <= 1);
+	}
+
+	// one processed payload at a time, the oldest makes room for the next
+	for (int i = 0; i < PAYLOAD_COUNT; i++) {
+		if (buffer_full(buf))
+			consume(buf, consumed++);
+
+		push_numbered(buf, pushed++);
+
+		assert(buf->len <= HIGH_WATER);
+		assert(buf->generation_count <= 1);
+	}
+
+	while (consumed < pushed)
+		consume(buf, consumed++);
+
+	// everything is processed, compaction releases every string
+	compact_buffer(buf);
+	assert(buf->generation_count == 0);
+	assert(buf->strings.chunks == NULL);
+	assert(buf->len == 0);
+	assert(buf->dropped == 2 * PAYLOAD_COUNT);
+
+	// processing whole windows drops each generation on the next push
+	for (int i = 0; i < PAYLOAD_COUNT; i++) {
+		if (buffer_full(buf))
+			while (buf->process_base < buf->len)
+				consume(buf, consumed++);
+
+		push_numbered(buf, pushed++);
+
+		assert(buf->cap <= HIGH_WATER);
+		assert(buf->generation_count == 0);
+	}
+
+	while (consumed < pushed)
+		consume(buf, consumed++);
+
+	destroy(buf);
+
+	// without streaming nothing is dropped
+	buf = new_buffer();
+
+	for (int i = 0; i < 100; i++) {
+		push_numbered(buf, i);
+		consume(buf, i);
+	}
+
+	assert(buf->len == 100);
+	assert(buf->dropped == 0);
+	assert(buf->cap >= 100);
+
+	destroy(buf);
+
+	check_report_order();
+	free_structural_index(&idx);
+
+	return EXIT_SUCCESS;
+}
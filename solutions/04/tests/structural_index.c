@@ -0,0 +1,72 @@
+#include "../src/structural_index.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define BLOCK_LEN 10007
+
+
+static void assert_same(const struct structural_index *a,
+			const struct structural_index *b)
+{
+	assert(a->mark_count == b->mark_count);
+	assert(a->line_count == b->line_count);
+	assert(memcmp(a->marks, b->marks,
+		      a->mark_count * sizeof(uint32_t)) == 0);
+	assert(memcmp(a->lines, b->lines,
+		      a->line_count * sizeof(struct line_end)) == 0);
+}
+
+int main()
+{
+	const char *text = "/login a b\n\n@x #y hi there";
+	struct structural_index idx = { .marks = NULL };
+	struct payload_line line;
+
+	build_structural_index(&idx, text, strlen(text));
+	assert(idx.line_count == 3);
+
+	indexed_line(&idx, text, 0, &line);
+	assert(line.start == 0 && line.end == 10 && line.mark_count == 3);
+	assert(line.marks[0] == 0 && line.marks[1] == 6);
+
+	indexed_line(&idx, text, 1, &line);
+	assert(line.start == 11 && line.end == 11 && line.mark_count == 0);
+
+	// last line has no trailing newline
+	indexed_line(&idx, text, 2, &line);
+	assert(line.start == 12 && line.end == strlen(text));
+	assert(line.mark_count == 5);
+
+	// every implementation produces the same index
+	static const char alphabet[] = "ab /@#\n";
+	char *block = malloc(BLOCK_LEN);
+	assert(block);
+
+	srand(0);
+	for (int i = 0; i < BLOCK_LEN; i++)
+		block[i] = alphabet[rand() % (sizeof(alphabet) - 1)];
+
+	struct structural_index scalar = { .marks = NULL };
+	build_structural_index_scalar(&scalar, block, BLOCK_LEN);
+	build_structural_index(&idx, block, BLOCK_LEN);
+	assert_same(&scalar, &idx);
+
+#if defined(__x86_64__) || defined(__i386__)
+	build_structural_index_sse2(&idx, block, BLOCK_LEN);
+	assert_same(&scalar, &idx);
+
+	if (__builtin_cpu_supports("avx2")) {
+		build_structural_index_avx2(&idx, block, BLOCK_LEN);
+		assert_same(&scalar, &idx);
+	}
+#endif
+
+	free(block);
+	free_structural_index(&scalar);
+	free_structural_index(&idx);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+#include "../src/dynamic_dispatch.h"
+#include "../src/parallel_ingest.h"
+#include "../src/payload.h"
+#include "../src/payload_file.h"
+#include "../src/wire_format.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char CORPUS[] =
+	"/login alice pass123\n"
+	"/join general\n"
+	"@alice @bob Hello everyone!\n"
+	"#general #random Check this out!\n"
+	"@a #b @c #d @e many receivers\n"
+	"@alice\n"
+	"Global message to all\n"
+	"/logout\n";
+
+
+static void assert_same_payload(const struct payload *p,
+				const struct payload *q)
+{
+	assert(p->vtable == q->vtable);
+
+	if (p->vtable == &command_login_vtable) {
+		assert(p->data.command_login.username ==
+		       q->data.command_login.username);
+		assert(strcmp(p->data.command_login.password,
+			      q->data.command_login.password) == 0);
+	} else if (p->vtable == &command_join_vtable) {
+		assert(p->data.command_join.channel ==
+		       q->data.command_join.channel);
+	} else if (p->vtable == &message_vtable) {
+		assert(strcmp(p->data.message.content,
+			      q->data.message.content) == 0);
+		assert(p->data.message.receiver_count ==
+		       q->data.message.receiver_count);
+
+		const struct message_receiving_entity *a = \
+			message_receivers(&p->data);
+		const struct message_receiving_entity *b = \
+			message_receivers(&q->data);
+
+		// names come back as the same interned pointers
+		for (int i = 0; i < p->data.message.receiver_count; i++) {
+			assert(a[i].vtable == b[i].vtable);
+			assert(a[i].additional_info == b[i].additional_info);
+		}
+	}
+}
+
+int main()
+{
+	struct payload_file file = { .data = CORPUS, .len = strlen(CORPUS) };
+
+	struct payload_buffer *parsed = new_buffer();
+	push_payloads_parallel(parsed, &file, 1);
+	assert(parsed->len == 8);
+
+	size_t len;
+	char *encoded = serialize_payloads(parsed->payloads, parsed->len,
+					   &len);
+
+	// decoding appends, and outlives the encoding
+	struct payload_buffer *decoded = new_buffer();
+	assert(deserialize_payloads(decoded, encoded, len));
+	assert(deserialize_payloads(decoded, encoded, len));
+	assert(decoded->len == 2 * parsed->len);
+
+	char *copy = malloc(len);
+	memcpy(copy, encoded, len);
+	memset(encoded, 0, len);
+
+	for (int i = 0; i < decoded->len; i++)
+		assert_same_payload(&parsed->payloads[i % parsed->len],
+				    &decoded->payloads[i]);
+
+	// every truncation and a few corruptions are rejected, nothing is
+	// appended then
+	for (size_t cut = 0; cut < len; cut++)
+		assert(!deserialize_payloads(decoded, copy, cut));
+
+	copy[0] = 'X';
+	assert(!deserialize_payloads(decoded, copy, len));
+	copy[0] = 'P';
+
+	// the name index of the login, right before the password length and
+	// the password, pointing past the name table; both take one byte
+	size_t password = 0;
+	while (memcmp(copy + password, "pass123", 8) != 0)
+		password++;
+
+	copy[password - 2] = 100;
+	assert(!deserialize_payloads(decoded, copy, len));
+
+	assert(decoded->len == 2 * parsed->len);
+
+	// a message claiming more receivers than there are bytes left, in one
+	// record and without names, is rejected before allocating them
+	static const char huge[] = {
+		'P', 'L', 'W', '1', 0x00, 0x01, 0x06,
+		WIRE_MESSAGE, 0xff, 0xff, 0xff, 0xff, 0x07, 0x00,
+	};
+	struct arena_chunk *chunks = decoded->strings.chunks;
+	int cap = decoded->cap;
+
+	assert(!deserialize_payloads(decoded, huge, sizeof(huge)));
+
+	// nor does a rejected encoding leave anything in buf
+	assert(!deserialize_payloads(decoded, copy, len - 1));
+	assert(decoded->strings.chunks == chunks);
+	assert(decoded->cap == cap);
+	assert(decoded->len == 2 * parsed->len);
+
+	// an empty batch is valid too
+	char *empty = serialize_payloads(NULL, 0, &len);
+	assert(deserialize_payloads(decoded, empty, len));
+	assert(decoded->len == 2 * parsed->len);
+
+	// a run of one encoding per payload, each behind its length, ends at
+	// a torn encoding
+	char *run = NULL;
+	size_t run_len = 0, run_cap = 0, whole = 0;
+
+	for (int i = 0; i < parsed->len; i++) {
+		size_t at = run_len;
+		uint32_t encoding_len;
+
+		run_len += sizeof(encoding_len);
+		if (run_len > run_cap) {
+			run_cap = run_len * 2;
+			run = realloc(run, run_cap);
+			assert(run);
+		}
+
+		serialize_payloads_append(&parsed->payloads[i], 1, &run,
+					  &run_len, &run_cap);
+		encoding_len = run_len - at - sizeof(encoding_len);
+		memcpy(run + at, &encoding_len, sizeof(encoding_len));
+
+		if (i == parsed->len - 2)
+			whole = run_len;
+	}
+
+	struct payload_buffer *runs = new_buffer();
+	size_t used;
+
+	assert(deserialize_payload_run(runs, run, run_len, &used) ==
+	       (size_t) parsed->len);
+	assert(used == run_len);
+	assert(deserialize_payload_run(runs, run, run_len - 1, &used) ==
+	       (size_t) parsed->len - 1);
+	assert(used == whole);
+	assert(runs->len == 2 * parsed->len - 1);
+
+	for (int i = 0; i < runs->len; i++)
+		assert_same_payload(&parsed->payloads[i % parsed->len],
+				    &runs->payloads[i]);
+
+	destroy(runs);
+	free(run);
+
+	free(empty);
+	free(copy);
+	free(encoded);
+	destroy(decoded);
+	destroy(parsed);
+
+	return EXIT_SUCCESS;
+}
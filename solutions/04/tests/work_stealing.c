@@ -0,0 +1,158 @@
+#include "../src/output_sink.h"
+#include "../src/payload.h"
+#include "../src/work_stealing.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+static const char CORPUS[] =
+	"/login alice pass\n"
+	"@alice hi\n"
+	"/join general\n"
+	"#general hello\n"
+	"global hello\n"
+	"@bob hey\n"
+	"/login bob pass\n"
+	"@carol @alice both\n"
+	"/logout\n"
+	"/logout\n"
+	"@alice after logout\n"
+	"/join general\n"
+	"#general bye\n"
+	"@dave @dave twice\n";
+
+#define CORPUS_PAYLOADS 14
+#define REPEAT 100
+#define PAYLOAD_COUNT (CORPUS_PAYLOADS * REPEAT)
+
+
+static const struct payload *first;
+static int processed[PAYLOAD_COUNT];
+static atomic_int processed_count;
+
+static void record(const struct payload *self)
+{
+	processed[atomic_fetch_add(&processed_count, 1)] = self - first;
+}
+
+/* recording copies of the real vtables */
+static struct payload_vtable recording[4];
+
+static void load(struct payload_buffer *buf)
+{
+	struct structural_index idx = { .marks = NULL };
+	build_structural_index(&idx, CORPUS, strlen(CORPUS));
+
+	for (int r = 0; r < REPEAT; r++)
+		for (size_t i = 0; i < idx.line_count; i++) {
+			struct payload_line line;
+			indexed_line(&idx, CORPUS, i, &line);
+			push_payload(buf, &line);
+		}
+
+	free_structural_index(&idx);
+
+	const struct payload_vtable *real[] = {
+		&command_login_vtable, &command_join_vtable,
+		&command_logout_vtable, &message_vtable,
+	};
+
+	for (int v = 0; v < 4; v++) {
+		recording[v] = *real[v];
+		recording[v].process = record;
+	}
+
+	for (int i = 0; i < buf->len; i++)
+		for (int v = 0; v < 4; v++)
+			if (buf->payloads[i].vtable == real[v])
+				buf->payloads[i].vtable = &recording[v];
+
+	first = buf->payloads;
+	atomic_store(&processed_count, 0);
+}
+
+static bool share_name(const struct payload *a, const struct payload *b)
+{
+	if (a->vtable->name == NULL || b->vtable->name == NULL)
+		return true;
+
+	const char *x, *y;
+	for (int i = 0; (x = a->vtable->name(a, i)); i++)
+		for (int j = 0; (y = b->vtable->name(b, j)); j++)
+			if (strcmp(x, y) == 0)
+				return true;
+
+	return false;
+}
+
+int main()
+{
+	static int position[PAYLOAD_COUNT];
+
+	for (int workers = 1; workers <= 8; workers *= 2) {
+		struct payload_buffer *buf = new_buffer();
+		load(buf);
+		assert(buf->len == PAYLOAD_COUNT);
+
+		assert(process_parallel(buf, workers) == PAYLOAD_COUNT);
+		assert(process_parallel(buf, workers) == 0);
+		assert(atomic_load(&processed_count) == PAYLOAD_COUNT);
+
+		for (int i = 0; i < PAYLOAD_COUNT; i++)
+			position[i] = -1;
+		for (int i = 0; i < PAYLOAD_COUNT; i++) {
+			// every payload ran exactly once
+			assert(position[processed[i]] < 0);
+			position[processed[i]] = i;
+		}
+
+		// payloads sharing a name, and barriers, keep their order
+		for (int i = 0; i < PAYLOAD_COUNT; i++)
+			for (int j = i + 1; j < PAYLOAD_COUNT; j++)
+				if (share_name(&first[i], &first[j]))
+					assert(position[i] < position[j]);
+
+		destroy(buf);
+	}
+
+	// only what is pending gets processed
+	struct payload_buffer *buf = new_buffer();
+	load(buf);
+	process_next(buf);
+	assert(process_parallel(buf, 0) == PAYLOAD_COUNT - 1);
+	assert(atomic_load(&processed_count) == PAYLOAD_COUNT);
+	destroy(buf);
+
+	// the workers cannot share a sink, running with one is refused
+	pid_t pid = fork();
+	assert(pid >= 0);
+
+	if (pid == 0) {
+		int null = open("/dev/null", O_WRONLY);
+		dup2(null, STDERR_FILENO);
+
+		struct output_sink out;
+		sink_open(&out, null, 0, false);
+		payload_output = &out;
+
+		buf = new_buffer();
+		load(buf);
+		process_parallel(buf, 2);
+
+		_exit(EXIT_SUCCESS);
+	}
+
+	int status;
+	waitpid(pid, &status, 0);
+	assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+
+	return EXIT_SUCCESS;
+}
@@ -2,21 +2,82 @@
 
 #include <cstring>
 #include <iostream>
+#include <utility>
 
-using std::ostream, std::cout, std::endl;
+using std::ostream, std::cout;
 
 
-String::String(const char *str) {
-    data = new char[strlen(str) + 1];
-    strcpy(data, str);
+String::String(const char *str)
+    : String { str, strlen(str) } {}
 
-    cout << "String created: " << data << endl;
+String::String(const char *str, std::size_t len_)
+    : data { buffer }, len { len_ } {
+    if (len > inline_capacity)
+        data = new char[len + 1];
+
+    memcpy(data, str, len);
+    data[len] = '\0';
+
+    cout << "String created: " << data << "\n";
+}
+
+String::String(const String &other)
+    : data { buffer }, len { other.len } {
+    if (len > inline_capacity)
+        data = new char[len + 1];
+
+    memcpy(data, other.data, len + 1);
+
+    cout << "String created: " << data << "\n";
+}
+
+String::String(String &&other) noexcept
+    : data { buffer }, len { other.len } {
+    if (other.is_inline()) {
+        memcpy(buffer, other.buffer, len + 1);
+    } else {
+        // the moved-from string is left empty, and owns nothing
+        data = std::exchange(other.data, other.buffer);
+        other.buffer[0] = '\0';
+        other.len = 0;
+    }
+
+    cout << "String created: " << data << "\n";
+}
+
+String &String::operator=(const String &other) {
+    if (this != &other)
+        *this = String { other };
+
+    return *this;
+}
+
+String &String::operator=(String &&other) noexcept {
+    if (this == &other)
+        return *this;
+
+    if (!is_inline())
+        delete[] data;
+
+    len = other.len;
+
+    if (other.is_inline()) {
+        data = buffer;
+        memcpy(buffer, other.buffer, len + 1);
+    } else {
+        data = std::exchange(other.data, other.buffer);
+        other.buffer[0] = '\0';
+        other.len = 0;
+    }
+
+    return *this;
 }
 
 String::~String() {
-    cout << "String destroyed: " << data << endl;
+    cout << "String destroyed: " << data << "\n";
 
-    delete[] data;
+    if (!is_inline())
+        delete[] data;
 }
 
 ostream &operator<<(ostream &os, const String &string) {
@@ -7,14 +7,25 @@
 #define STRING_HPP
 
 
+#include <cstddef>
 #include <ostream>
 
 
 /**
  * @brief Custom string class implementation as a RAII example.
+ *
+ * Strings of up to inline_capacity characters are stored inside the object
+ * itself (small-string optimization), only longer ones are allocated on the
+ * heap. Names in payloads are almost always that short.
+ *
+ * Every constructor and the destructor print the string, so the output
+ * shows when each String is created and destroyed.
  */
 class String {
 public:
+    /** @brief Longest string stored without a heap allocation. */
+    static constexpr std::size_t inline_capacity = 15;
+
     /**
      * @brief Construct String from str literal.
      *
@@ -22,8 +33,27 @@ public:
      */
     String(const char *str);
 
+    /**
+     * @brief Construct String from the first len characters of str.
+     *
+     * str does not need to be NUL-terminated, its length is not measured
+     * again.
+     */
+    String(const char *str, std::size_t len);
+
+    /** @brief Deep copy. */
+    String(const String &other);
+
+    /** @brief Takes over the heap buffer of other, which becomes empty. */
+    String(String &&other) noexcept;
+
+    String &operator=(const String &other);
+    String &operator=(String &&other) noexcept;
+
     ~String();
 
+    std::size_t size() const noexcept { return len; }
+
 private:
     // We will discuss operator overloading in detail. Here is a quick
     // reference if you want to be familiar with it beforehand:
@@ -36,7 +66,11 @@ private:
     friend std::ostream& operator<<(std::ostream& stream,
                                     const String& matrix);
 
-    char *data;
+    bool is_inline() const noexcept { return data == buffer; }
+
+    char *data;  // points to buffer for short strings
+    std::size_t len;
+    char buffer[inline_capacity + 1];
 };
 
 
@@ -0,0 +1,72 @@
+#include "../src/payload.hpp"
+#include "../src/string.hpp"
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+
+// every heap allocation of the program goes through these
+
+static int allocations = 0;
+
+void *operator new(std::size_t size) {
+    allocations++;
+
+    if (void *p = std::malloc(size))
+        return p;
+
+    throw std::bad_alloc {};
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+
+int main() {
+    allocations = 0;
+
+    // typical names fit inline
+    {
+        LoginCommand login { "alice", "pass123" };
+        JoinCommand join { "general" };
+        String name { "announcements", 13 };
+        String copy { name };
+        String moved { std::move(copy) };
+    }
+
+    assert(allocations == 0);
+
+    // up to the inline capacity
+    String longest { "fifteen chars!!" };
+    assert(longest.size() == String::inline_capacity);
+    assert(allocations == 0);
+
+    // longer strings are allocated once, and moving them allocates nothing
+    String heap { "sixteen chars!!!" };
+    assert(allocations == 1);
+
+    String moved { std::move(heap) };
+    assert(allocations == 1);
+
+    String copy { moved };
+    assert(allocations == 2);
+}
@@ -1,13 +1,55 @@
 #include "../src/string.hpp"
 
+#include <cassert>
 #include <iostream>
+#include <sstream>
+#include <utility>
 
 using std::cout, std::endl;
 
 
+static std::string str(const String &string) {
+    std::ostringstream os;
+    os << string;
+
+    return os.str();
+}
+
 int main() {
     String str1 = String("Hello,");
     String str2 = String("World!");
 
     cout << "Values of strings:\n1. " << str1 << "\n" << "2. " << str2 << endl;
+
+    // spans need no NUL terminator
+    String span { "alice bob", 5 };
+    assert(str(span) == "alice" && span.size() == 5);
+
+    const char *long_text = "a string too long to be stored inline";
+
+    for (const char *text : { "short", long_text }) {
+        String original { text };
+
+        // copies are deep
+        String copy { original };
+        assert(str(copy) == text && str(original) == text);
+
+        // moves leave the source empty, or untouched if it is inline
+        String moved { std::move(copy) };
+        assert(str(moved) == text);
+
+        String assigned { "x" };
+        assigned = moved;
+        assert(str(assigned) == text && str(moved) == text);
+
+        assigned = std::move(moved);
+        assert(str(assigned) == text);
+
+        assigned = assigned;
+        assert(str(assigned) == text);
+
+        String other { "to be replaced by a long string, on the heap" };
+        other = std::move(assigned);
+        assert(str(other) == text);
+    }
 }
@@ -0,0 +1,91 @@
+#include "../src/output_sink.hpp"
+#include "../src/payload.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <unistd.h>
+#include <vector>
+
+
+constexpr int payload_count = 1000000;
+
+
+/* processes every payload with output going to out, returns seconds */
+static double run(const std::vector<std::unique_ptr<Payload>> &payloads,
+                  std::ostream &out) {
+    payload_output = &out;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (auto &payload : payloads)
+        payload->process();
+    out.flush();
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+/* the same output with std::endl, as the payloads used to print it */
+static double run_endl(const std::vector<std::unique_ptr<Payload>> &payloads,
+                       std::ostream &out) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < (int) payloads.size(); i++)
+        out << "Direct message to " << "bob" << ": "
+            << "How are you doing?" << std::endl;
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+int main() {
+    std::vector<std::unique_ptr<Payload>> payloads;
+    for (int i = 0; i < payload_count; i++)
+        payloads.push_back(std::make_unique<DirectMessage>(
+            "How are you doing?", "bob"));
+
+    char path[] = "/tmp/output_sink_benchXXXXXX";
+    int fd = mkstemp(path);
+
+    std::printf("%-24s %12s %10s\n", "output to a file", "ns/payload",
+                "speedup");
+
+    auto report = [](const char *label, double elapsed, double base) {
+        std::printf("%-24s %12.1f %9.2fx\n", label,
+                    elapsed * 1e9 / payload_count, base / elapsed);
+    };
+
+    double flushed;
+    {
+        std::ofstream file { path };
+        flushed = run_endl(payloads, file);
+        report("ofstream, std::endl", flushed, flushed);
+    }
+    {
+        std::ofstream file { path };
+        report("ofstream, '\\n'", run(payloads, file), flushed);
+    }
+    for (bool async : { false, true }) {
+        ftruncate(fd, 0);
+        lseek(fd, 0, SEEK_SET);
+
+        OutputSink sink { fd, OutputSink::default_capacity, async };
+        std::ostream out { &sink };
+        report(async ? "async OutputSink" : "OutputSink",
+               run(payloads, out), flushed);
+    }
+
+    payload_output = nullptr;
+    close(fd);
+    std::remove(path);
+
+    return EXIT_SUCCESS;
+}
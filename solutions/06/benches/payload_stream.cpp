@@ -0,0 +1,85 @@
+#include "../src/payload.hpp"
+#include "../src/payload_stream.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+constexpr int line_count = 1000000;
+constexpr int runs = 5;
+constexpr std::size_t early_stop = 1000;
+
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+/* line i of the mix, every type in turn */
+static const char *line(int i) {
+    switch (i % 6) {
+    case 0: return "/login alice pass123\n";
+    case 1: return "/join general\n";
+    case 2: return "/logout\n";
+    case 3: return "@bob How are you doing?\n";
+    case 4: return "#announcements Server maintenance\n";
+    default: return "Hello, world!\n";
+    }
+}
+
+int main() {
+    // A stream without a buffer is permanently failed and drops its input
+    // right away, so processing measures parsing and dispatch.
+    std::ostream discard { nullptr };
+    payload_output = &discard;
+
+    std::string text;
+    for (int i = 0; i < line_count; i++)
+        text += line(i);
+
+    double eager = 1e30, lazy = 1e30, first = 1e30;
+    std::size_t peak = 0;
+
+    for (int r = 0; r < runs; r++) {
+        // everything parsed up front, then processed
+        std::istringstream input { text };
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::unique_ptr<Payload>> payloads;
+        for (auto &payload : parse_payloads(input))
+            payloads.push_back(std::move(payload));
+        for (auto &payload : payloads)
+            payload->process();
+        peak = payloads.size();
+        payloads.clear();
+
+        eager = std::min(eager, seconds_since(start));
+
+        // one payload alive at a time
+        input = std::istringstream { text };
+        start = std::chrono::steady_clock::now();
+        process(parse_payloads(input));
+        lazy = std::min(lazy, seconds_since(start));
+
+        // a pipeline that only needs the first few payloads
+        input = std::istringstream { text };
+        start = std::chrono::steady_clock::now();
+        process(take(parse_payloads(input), early_stop));
+        first = std::min(first, seconds_since(start));
+    }
+
+    std::printf("%-22s %12s %14s\n", "pipeline", "ms", "payloads held");
+    std::printf("%-22s %12.1f %14zu\n", "eager, then process", eager * 1e3,
+                peak);
+    std::printf("%-22s %12.1f %14d\n", "generator", lazy * 1e3, 1);
+    std::printf("%-22s %12.3f %14d\n", "generator, first 1000", first * 1e3,
+                1);
+}
@@ -0,0 +1,140 @@
+#include "../src/payload.hpp"
+#include "../src/payload_variant.hpp"
+#include "../src/poly_vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+constexpr int payload_count = 1000000;
+constexpr int runs = 5;
+
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+/* payload i of the mix, every type in turn */
+template <typename Make>
+static void make_payload(int i, Make make) {
+    switch (i % 6) {
+    case 0: make(LoginCommand { "alice", "pass123" }); break;
+    case 1: make(JoinCommand { "general" }); break;
+    case 2: make(LogoutCommand {}); break;
+    case 3: make(DirectMessage { "How are you doing?", "bob" }); break;
+    case 4: make(GroupMessage { "Server maintenance", "announcements" });
+        break;
+    default: make(GlobalMessage { "Hello, world!" });
+    }
+}
+
+struct Timings {
+    double construct = 1e30, process = 1e30, destroy = 1e30;
+
+    void report(const char *label) const {
+        std::printf("%-10s %12.1f %12.1f %12.1f\n", label,
+                    construct * 1e9 / payload_count,
+                    process * 1e9 / payload_count,
+                    destroy * 1e9 / payload_count);
+    }
+};
+
+int main() {
+    // A stream without a buffer is permanently failed and drops its input
+    // right away, so processing measures dispatch instead of formatting.
+    std::ostream discard { nullptr };
+    payload_output = &discard;
+
+    Timings virtual_timings, variant_timings, poly_timings;
+
+    for (int r = 0; r < runs; r++) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Payload *> objects;
+        objects.reserve(payload_count);
+        for (int i = 0; i < payload_count; i++)
+            make_payload(i, [&](auto &&payload) {
+                using T = std::decay_t<decltype(payload)>;
+                objects.push_back(new T { std::move(payload) });
+            });
+        virtual_timings.construct =
+            std::min(virtual_timings.construct, seconds_since(start));
+
+        start = std::chrono::steady_clock::now();
+        for (Payload *payload : objects)
+            payload->process();
+        virtual_timings.process =
+            std::min(virtual_timings.process, seconds_since(start));
+
+        start = std::chrono::steady_clock::now();
+        for (Payload *payload : objects)
+            delete payload;
+        objects.clear();
+        objects.shrink_to_fit();
+        virtual_timings.destroy =
+            std::min(virtual_timings.destroy, seconds_since(start));
+
+        start = std::chrono::steady_clock::now();
+        std::vector<PayloadVariant> values;
+        values.reserve(payload_count);
+        for (int i = 0; i < payload_count; i++)
+            make_payload(i, [&](auto &&payload) {
+                values.emplace_back(std::move(payload));
+            });
+        variant_timings.construct =
+            std::min(variant_timings.construct, seconds_since(start));
+
+        start = std::chrono::steady_clock::now();
+        for (PayloadVariant &payload : values)
+            process(payload);
+        variant_timings.process =
+            std::min(variant_timings.process, seconds_since(start));
+
+        start = std::chrono::steady_clock::now();
+        values.clear();
+        values.shrink_to_fit();
+        variant_timings.destroy =
+            std::min(variant_timings.destroy, seconds_since(start));
+
+        start = std::chrono::steady_clock::now();
+        PolyVector<Payload> packed;
+        // no payload is larger than the variant holding it
+        packed.reserve(payload_count * sizeof(PayloadVariant), payload_count);
+        for (int i = 0; i < payload_count; i++)
+            make_payload(i, [&](auto &&payload) {
+                using T = std::decay_t<decltype(payload)>;
+                packed.emplace_back<T>(std::move(payload));
+            });
+        poly_timings.construct =
+            std::min(poly_timings.construct, seconds_since(start));
+
+        start = std::chrono::steady_clock::now();
+        for (Payload &payload : packed)
+            payload.process();
+        poly_timings.process =
+            std::min(poly_timings.process, seconds_since(start));
+
+        start = std::chrono::steady_clock::now();
+        packed = PolyVector<Payload> {};
+        poly_timings.destroy =
+            std::min(poly_timings.destroy, seconds_since(start));
+    }
+
+    payload_output = nullptr;
+
+    std::printf("%-10s %12s %12s %12s\n", "ns/payload", "construct",
+                "process", "destroy");
+    virtual_timings.report("virtual");
+    variant_timings.report("variant");
+    poly_timings.report("poly");
+
+    return EXIT_SUCCESS;
+}
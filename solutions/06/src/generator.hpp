@@ -0,0 +1,142 @@
+/**
+ * @file generator.hpp
+ * @brief Lazy sequences produced by C++20 coroutines.
+ */
+
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+
+/**
+ * @brief Sequence of the values a coroutine co_yields.
+ *
+ * The coroutine does not start before begin() and runs up to its next
+ * co_yield whenever the iterator is advanced, so only the current value
+ * exists at any time. Values are yielded by reference and may be moved out
+ * of through the iterator. Destroying the generator destroys a coroutine
+ * suspended halfway, together with its locals, which is how a consumer
+ * stops early.
+ */
+template<typename T>
+class Generator {
+public:
+    using value_type = std::remove_cvref_t<T>;
+
+    struct promise_type {
+        Generator get_return_object() {
+            return Generator {
+                std::coroutine_handle<promise_type>::from_promise(*this)
+            };
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        // the yielded object lives until the coroutine resumes
+        std::suspend_always yield_value(value_type &value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+
+        std::suspend_always yield_value(value_type &&value) noexcept {
+            current = std::addressof(value);
+            return {};
+        }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() { exception = std::current_exception(); }
+
+        // no co_await inside generators
+        template<typename U>
+        std::suspend_never await_transform(U &&) = delete;
+
+        value_type *current = nullptr;
+        std::exception_ptr exception;
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Generator::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type &;
+        using pointer = value_type *;
+
+        Iterator() = default;
+        explicit Iterator(Handle handle_) : handle { handle_ } {}
+
+        reference operator*() const { return *handle.promise().current; }
+        pointer operator->() const { return handle.promise().current; }
+
+        Iterator &operator++() {
+            resume(handle);
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const {
+            return !handle || handle.done();
+        }
+
+    private:
+        Handle handle;
+    };
+
+    Generator(Generator &&other) noexcept
+        : handle { std::exchange(other.handle, {}) } {}
+
+    Generator &operator=(Generator &&other) noexcept {
+        if (this != &other) {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+
+    ~Generator() {
+        if (handle)
+            handle.destroy();
+    }
+
+    /**
+     * @brief Runs the coroutine up to its first value; call only once.
+     */
+    Iterator begin() {
+        if (handle)
+            resume(handle);
+        return Iterator { handle };
+    }
+
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    explicit Generator(Handle handle_) : handle { handle_ } {}
+
+    // exceptions thrown by the coroutine come out where it was resumed
+    static void resume(Handle handle) {
+        handle.resume();
+
+        if (handle.promise().exception)
+            std::rethrow_exception(
+                std::exchange(handle.promise().exception, {}));
+    }
+
+    Handle handle;
+};
+
+
+#endif
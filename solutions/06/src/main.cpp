@@ -1,19 +1,57 @@
+#include "output_sink.hpp"
 #include "payload.hpp"
+#include "payload_stream.hpp"
+#include "poly_vector.hpp"
 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <unistd.h>
 
-int main() {
-    Payload *payloads[6];
-    payloads[0] = new LoginCommand { "alice", "pass123" };
-    payloads[1] = new JoinCommand { "general" };
-    payloads[2] = new LogoutCommand {};
 
-    payloads[3] = new DirectMessage { "How are you doing?", "bob" };
-    payloads[4] = new GroupMessage { "Server maintainence tonight", "announcements" };
-    payloads[5] = new GlobalMessage { "Hello, world!" };
+/* usage: main [FILE [--limit N]], without a file the built-in payloads */
+int main(int argc, const char **args) {
+    // payloads print into a large buffer that a background thread writes out
+    OutputSink sink { STDOUT_FILENO, OutputSink::default_capacity, true };
+    std::ostream out { &sink };
+    payload_output = &out;
 
-    for (int i = 0; i < 6; i++)
-        payloads[i]->process();
+    if (argc > 1) {
+        std::ifstream input { args[1] };
+        if (!input) {
+            std::cerr << "Could not open " << args[1] << ".\n";
+            return EXIT_FAILURE;
+        }
 
-    for (int i = 0; i < 6; i++)
-        delete payloads[i];
+        std::size_t limit = SIZE_MAX;
+        if (argc > 3 && std::strcmp(args[2], "--limit") == 0)
+            limit = std::strtoull(args[3], nullptr, 10);
+
+        // each line is parsed when its payloads are next, and nothing past
+        // the limit is read
+        process(take(parse_payloads(input), limit));
+
+        out.flush();
+        return EXIT_SUCCESS;
+    }
+
+    // payloads of every type share one buffer, in order
+    PolyVector<Payload> payloads;
+    payloads.emplace_back<LoginCommand>("alice", "pass123");
+    payloads.emplace_back<JoinCommand>("general");
+    payloads.emplace_back<LogoutCommand>();
+
+    payloads.emplace_back<DirectMessage>("How are you doing?", "bob");
+    payloads.emplace_back<GroupMessage>("Server maintainence tonight", "announcements");
+    payloads.emplace_back<GlobalMessage>("Hello, world!");
+
+    for (Payload &payload : payloads)
+        payload.process();
+
+    payloads.clear();
+
+    out.flush();
 }
@@ -0,0 +1,168 @@
+#include "output_sink.hpp"
+
+#include <cassert>
+#include <cerrno>
+#include <sys/uio.h>
+
+
+namespace {
+
+/* writes every byte described by iov, retrying after short writes */
+void write_all(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+
+        if (written < 0 && errno == EINTR)
+            continue;
+        assert(written >= 0);
+
+        while (count > 0 && (std::size_t) written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+
+        if (count > 0) {
+            iov->iov_base = (char *) iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+}
+
+
+OutputSink::OutputSink(int fd_, std::size_t capacity, bool async_)
+    : fd { fd_ }, async { async_ }, buffer(capacity) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+
+    if (async) {
+        spare.resize(capacity);
+        writer = std::thread { &OutputSink::write_spare, this };
+    }
+}
+
+OutputSink::~OutputSink() {
+    sync();
+
+    if (async) {
+        {
+            std::lock_guard guard { lock };
+            closing = true;
+        }
+        changed.notify_all();
+        writer.join();
+    }
+}
+
+OutputSink::int_type OutputSink::overflow(int_type ch) {
+    drain();
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize OutputSink::xsputn(const char *data, std::streamsize len) {
+    std::size_t room = epptr() - pptr();
+
+    if ((std::size_t) len > room) {
+        if ((std::size_t) len >= buffer.size()) {
+            // too large to be worth copying
+            drain(data, len);
+            return len;
+        }
+
+        drain();
+    }
+
+    traits_type::copy(pptr(), data, len);
+    pbump(len);
+
+    return len;
+}
+
+int OutputSink::sync() {
+    drain();
+
+    if (async)
+        wait_idle();
+
+    return 0;
+}
+
+void OutputSink::drain(const char *data, std::size_t len) {
+    std::size_t buffered = pptr() - pbase();
+
+    if (buffered == 0 && len == 0)
+        return;
+
+    if (async) {
+        if (buffered > 0)
+            submit();
+
+        if (len > 0) {
+            // earlier output must be written first
+            wait_idle();
+
+            struct iovec iov = { (char *) data, len };
+            write_all(fd, &iov, 1);
+        }
+
+        return;
+    }
+
+    // one syscall for both the buffer and data
+    struct iovec iov[2] = {
+        { buffer.data(), buffered },
+        { (char *) data, len },
+    };
+
+    write_all(fd, iov, 2);
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+/* hands the filled buffer to the writer thread and continues in the spare */
+void OutputSink::submit() {
+    wait_idle();
+
+    {
+        std::lock_guard guard { lock };
+
+        spare_len = pptr() - pbase();
+        buffer.swap(spare);
+        busy = true;
+    }
+    changed.notify_all();
+
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+void OutputSink::wait_idle() {
+    std::unique_lock guard { lock };
+    changed.wait(guard, [this] { return !busy; });
+}
+
+void OutputSink::write_spare() {
+    std::unique_lock guard { lock };
+
+    for (;;) {
+        changed.wait(guard, [this] { return busy || closing; });
+
+        if (!busy)
+            break;
+
+        // the spare buffer is ours until busy is cleared
+        guard.unlock();
+
+        struct iovec iov = { spare.data(), spare_len };
+        write_all(fd, &iov, 1);
+
+        guard.lock();
+        busy = false;
+        changed.notify_all();
+    }
+}
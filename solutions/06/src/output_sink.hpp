@@ -0,0 +1,66 @@
+/**
+ * @file output_sink.hpp
+ * @brief Buffered, optionally asynchronous output for the payloads.
+ */
+
+#ifndef OUTPUT_SINK_HPP
+#define OUTPUT_SINK_HPP
+
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Stream buffer writing to a file descriptor in large batches.
+ *
+ * Output is collected in a large buffer and written with a single writev
+ * once it is full, together with anything too large to be worth copying.
+ * In async mode a writer thread drains one buffer while the stream fills the
+ * other. Wrap it in an std::ostream to use it.
+ */
+class OutputSink : public std::streambuf {
+public:
+    static constexpr std::size_t default_capacity = 1 << 16;
+
+    explicit OutputSink(int fd_, std::size_t capacity = default_capacity,
+                        bool async_ = false);
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator=(const OutputSink &) = delete;
+
+    /** Writes what is left and stops the writer thread. */
+    ~OutputSink() override;
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char *data, std::streamsize len) override;
+    int sync() override;
+
+private:
+    /** Writes the buffer, followed by len bytes of data. */
+    void drain(const char *data = nullptr, std::size_t len = 0);
+    void submit();
+    void wait_idle();
+    void write_spare();
+
+    int fd;
+    bool async;
+
+    std::vector<char> buffer;
+    std::vector<char> spare;
+    std::size_t spare_len = 0;
+
+    std::mutex lock;
+    std::condition_variable changed;
+    bool busy = false;
+    bool closing = false;
+    std::thread writer;
+};
+
+
+#endif
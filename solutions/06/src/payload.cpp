@@ -2,41 +2,33 @@
 
 #include <iostream>
 
-using std::cout, std::endl;
 
+// '\n' instead of std::endl, flushing is up to the stream
+thread_local std::ostream *payload_output = &std::cout;
 
-void Command::process() {
-    cout << "Command: " << command_name << endl;
-    process_arguments();
-}
 
 void LoginCommand::process_arguments() {
-    cout << "  Arguments: [username: " << username
-        << ", password: " << password << "]" << endl;
+    *payload_output << "  Arguments: [username: " << username
+        << ", password: " << password << "]\n";
 }
 
 void JoinCommand::process_arguments() {
-    cout << "  Arguments: [channel: " << channel << "]" << endl;
+    *payload_output << "  Arguments: [channel: " << channel << "]\n";
 }
 
 void LogoutCommand::process_arguments() {
-    cout << "  Arguments: []" << endl;
+    *payload_output << "  Arguments: []\n";
 }
 
 
-void Message::process() {
-    process_recipient();
-    cout << content << endl;
-}
-
 void DirectMessage::process_recipient() {
-    cout << "Direct message to " << username << ": ";
+    *payload_output << "Direct message to " << username << ": ";
 }
 
 void GroupMessage::process_recipient() {
-    cout << "Group message to " << channel << ": ";
+    *payload_output << "Group message to " << channel << ": ";
 }
 
 void GlobalMessage::process_recipient() {
-    cout << "Global message: ";
+    *payload_output << "Global message: ";
 }
@@ -7,9 +7,17 @@
 #define PAYLOAD_HPP
 
 
+#include <ostream>
 #include <string>
 
 
+/**
+ * @brief Stream the payloads of the calling thread print to, std::cout
+ * unless changed.
+ */
+extern thread_local std::ostream *payload_output;
+
+
 class Payload {
 public:
     virtual void process() = 0;
@@ -24,9 +32,12 @@ public:
     Command(const char *command_name_)
         : command_name { command_name_ } {};
 
-    void process() override;
-
-    virtual ~Command() = default;
+    // defined inline, so that where the concrete type is known (see
+    // payload_variant.hpp) process_arguments is devirtualized as well
+    void process() override {
+        *payload_output << "Command: " << command_name << '\n';
+        process_arguments();
+    }
 
 private:
     virtual void process_arguments() = 0;
@@ -35,7 +46,7 @@ private:
 };
 
 /* Command types ----------------------------------------------------------- */
-class LoginCommand : public Command {
+class LoginCommand final : public Command {
 public:
     LoginCommand(const char *username_, const char *password_)
         : Command { "login" }, username { username_ }, password { password_ } {}
@@ -47,7 +58,7 @@ private:
     std::string password;
 };
 
-class JoinCommand : public Command {
+class JoinCommand final : public Command {
 public:
     JoinCommand(const char *channel_)
         : Command { "join" }, channel { channel_ } {}
@@ -58,7 +69,7 @@ private:
     std::string channel;
 };
 
-class LogoutCommand : public Command {
+class LogoutCommand final : public Command {
 public:
     LogoutCommand()
         : Command { "logout" } {}
@@ -74,7 +85,10 @@ public:
     Message(const char *content_)
         : content { content_ } {}
 
-    void process() override;
+    void process() override {
+        process_recipient();
+        *payload_output << content << '\n';
+    }
 
 private:
     virtual void process_recipient() = 0;
@@ -83,7 +97,7 @@ private:
 };
 
 /* Message types ----------------------------------------------------------- */
-class DirectMessage : public Message {
+class DirectMessage final : public Message {
 public:
     DirectMessage(const char *content_, const char *username_)
         : Message { content_ }, username { username_ } {}
@@ -94,7 +108,7 @@ private:
     std::string username;
 };
 
-class GroupMessage : public Message {
+class GroupMessage final : public Message {
 public:
     GroupMessage(const char *content_, const char *channel_)
         : Message { content_ }, channel { channel_ } {}
@@ -105,7 +119,7 @@ private:
     std::string channel;
 };
 
-class GlobalMessage : public Message {
+class GlobalMessage final : public Message {
 public:
     GlobalMessage(const char *content_)
         : Message { content_ } {}
@@ -0,0 +1,108 @@
+#include "payload_stream.hpp"
+
+#include <string>
+#include <string_view>
+
+
+// splits off the token up to the next space, skipping spaces before it
+static std::string_view next_token(std::string_view &rest) {
+    std::size_t start = rest.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+        rest = {};
+        return {};
+    }
+
+    std::size_t end = rest.find(' ', start);
+    if (end == std::string_view::npos)
+        end = rest.size();
+
+    std::string_view token = rest.substr(start, end - start);
+    rest.remove_prefix(end);
+
+    return token;
+}
+
+// the command of a line starting with '/', nullptr if it is invalid
+static std::unique_ptr<Payload> parse_command(std::string_view rest) {
+    std::string_view name = next_token(rest);
+
+    if (name == "login") {
+        std::string username { next_token(rest) };
+        std::string password { next_token(rest) };
+
+        if (!username.empty() && !password.empty())
+            return std::make_unique<LoginCommand>(username.c_str(),
+                                                  password.c_str());
+    } else if (name == "join") {
+        std::string channel { next_token(rest) };
+
+        if (!channel.empty())
+            return std::make_unique<JoinCommand>(channel.c_str());
+    } else if (name == "logout") {
+        return std::make_unique<LogoutCommand>();
+    }
+
+    *payload_output << "Ignoring invalid command " << name << '\n';
+    return nullptr;
+}
+
+Generator<std::unique_ptr<Payload>> parse_payloads(std::istream &input) {
+    std::string line;
+
+    while (std::getline(input, line)) {
+        std::string_view rest = line;
+
+        if (rest.empty())
+            continue;
+
+        if (rest.front() == '/') {
+            if (std::unique_ptr<Payload> command = parse_command(
+                    rest.substr(1)))
+                co_yield std::move(command);
+            continue;
+        }
+
+        // receivers lead the line, the content follows them after a space
+        std::string_view content = rest;
+        std::size_t receivers = 0;
+
+        for (std::string_view token;
+             !(token = next_token(rest)).empty() &&
+             (token.front() == '@' || token.front() == '#');) {
+            receivers++;
+            content = rest.empty() ? rest : rest.substr(1);
+        }
+
+        if (receivers == 0) {
+            co_yield std::make_unique<GlobalMessage>(line.c_str());
+            continue;
+        }
+
+        std::string text { content };
+        rest = line;
+
+        // one payload per receiver
+        for (std::size_t i = 0; i < receivers; i++) {
+            std::string_view token = next_token(rest);
+            std::string name { token.substr(1) };
+
+            if (token.front() == '@')
+                co_yield std::make_unique<DirectMessage>(text.c_str(),
+                                                         name.c_str());
+            else
+                co_yield std::make_unique<GroupMessage>(text.c_str(),
+                                                        name.c_str());
+        }
+    }
+}
+
+std::size_t process(Generator<std::unique_ptr<Payload>> payloads) {
+    std::size_t processed = 0;
+
+    for (std::unique_ptr<Payload> &payload : payloads) {
+        payload->process();
+        processed++;
+    }
+
+    return processed;
+}
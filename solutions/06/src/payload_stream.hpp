@@ -0,0 +1,82 @@
+/**
+ * @file payload_stream.hpp
+ * @brief Lazy parsing of payload lines and pipeline stages pulling from it.
+ *
+ * parse_payloads reads a line only when the next payload is pulled, and the
+ * stages are generators over generators, so a pipeline such as
+ *
+ *     process(take(filter(parse_payloads(input), is_message), 10));
+ *
+ * holds a single payload at a time and stops reading the input once the
+ * tenth message has been processed.
+ */
+
+#ifndef PAYLOAD_STREAM_HPP
+#define PAYLOAD_STREAM_HPP
+
+
+#include "generator.hpp"
+#include "payload.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+
+/**
+ * @brief Payloads of the lines of input, parsed as they are pulled.
+ *
+ * A message with several receivers yields one payload per receiver, a line
+ * without receivers a global message. Empty lines are skipped; invalid
+ * commands are reported to payload_output and skipped.
+ */
+Generator<std::unique_ptr<Payload>> parse_payloads(std::istream &input);
+
+/**
+ * @brief The values of source that keep returns true for.
+ */
+template<typename T, typename Predicate>
+Generator<T> filter(Generator<T> source, Predicate keep) {
+    for (auto &value : source)
+        if (std::invoke(keep, std::as_const(value)))
+            co_yield std::move(value);
+}
+
+/**
+ * @brief The results of f for the values of source.
+ */
+template<typename T, typename Function>
+auto transform(Generator<T> source, Function f)
+    -> Generator<std::invoke_result_t<Function &, T &&>> {
+    for (auto &value : source)
+        co_yield std::invoke(f, std::move(value));
+}
+
+/**
+ * @brief The first count values of source; nothing after them is pulled.
+ */
+template<typename T>
+Generator<T> take(Generator<T> source, std::size_t count) {
+    if (count == 0)
+        co_return;
+
+    for (auto &value : source) {
+        co_yield std::move(value);
+
+        if (--count == 0)
+            co_return;
+    }
+}
+
+/**
+ * @brief Processes every payload of the source, one at a time.
+ *
+ * @return Number of payloads processed
+ */
+std::size_t process(Generator<std::unique_ptr<Payload>> payloads);
+
+
+#endif
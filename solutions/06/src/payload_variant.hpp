@@ -0,0 +1,35 @@
+/**
+ * @file payload_variant.hpp
+ * @brief Closed set of payload types, stored by value.
+ *
+ * Payload behind a pointer is open for extension, but every payload is a
+ * heap object of its own and every call goes through the vtable twice.
+ * When the protocol is fixed, a variant over the concrete types stores
+ * payloads by value in contiguous memory, and std::visit dispatches on the
+ * variant index. The concrete types are final, so the calls it makes are
+ * direct and the inline parts are inlined.
+ */
+
+#ifndef PAYLOAD_VARIANT_HPP
+#define PAYLOAD_VARIANT_HPP
+
+
+#include "payload.hpp"
+
+#include <variant>
+
+
+using PayloadVariant = std::variant<LoginCommand, JoinCommand, LogoutCommand,
+                                    DirectMessage, GroupMessage,
+                                    GlobalMessage>;
+
+
+/**
+ * @brief Processes a payload without a virtual call.
+ */
+inline void process(PayloadVariant &payload) {
+    std::visit([](auto &concrete) { concrete.process(); }, payload);
+}
+
+
+#endif
@@ -0,0 +1,252 @@
+/**
+ * @file poly_vector.hpp
+ * @brief Contiguous storage for objects of different types sharing a base.
+ */
+
+#ifndef POLY_VECTOR_HPP
+#define POLY_VECTOR_HPP
+
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Growable sequence of objects derived from Base, stored by value.
+ *
+ * Objects of any size are constructed back to back in one byte buffer, each
+ * at the alignment its type requires, so walking the sequence reads memory
+ * in order instead of chasing one heap pointer per object. The set of types
+ * stays open: anything derived from Base with a virtual destructor fits.
+ * When the buffer grows, every object is move constructed into the new one
+ * at the same offset and the old object destroyed.
+ *
+ * References to elements are invalidated by emplace_back whenever it grows
+ * the buffer, as with std::vector.
+ */
+template <typename Base>
+class PolyVector {
+    static_assert(std::has_virtual_destructor_v<Base>,
+                  "elements are destroyed through Base");
+
+    /** Alignment of the buffer, and so the largest an element may need. */
+    static constexpr std::size_t buffer_alignment =
+        alignof(std::max_align_t);
+
+    struct Entry {
+        /** Position of the object in the buffer. */
+        std::size_t offset;
+        /** Position of its Base subobject relative to the object. */
+        std::ptrdiff_t base_offset;
+        /** Moves the object from one address to another. */
+        void (*relocate)(std::byte *from, std::byte *to);
+    };
+
+public:
+    template <bool Const>
+    class Iterator {
+        using Element = std::conditional_t<Const, const Base, Base>;
+        using Bytes = std::conditional_t<Const, const std::byte, std::byte>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Base;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Element *;
+        using reference = Element &;
+
+        Iterator() = default;
+
+        Iterator(const Entry *entry_, Bytes *buffer_)
+            : entry { entry_ }, buffer { buffer_ } {}
+
+        reference operator*() const {
+            return *std::launder(reinterpret_cast<pointer>(
+                buffer + entry->offset + entry->base_offset));
+        }
+
+        pointer operator->() const { return &**this; }
+
+        Iterator &operator++() {
+            ++entry;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++entry;
+            return previous;
+        }
+
+        bool operator==(const Iterator &other) const {
+            return entry == other.entry;
+        }
+
+        bool operator!=(const Iterator &other) const {
+            return entry != other.entry;
+        }
+
+    private:
+        const Entry *entry = nullptr;
+        Bytes *buffer = nullptr;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    PolyVector() = default;
+
+    PolyVector(const PolyVector &) = delete;
+    PolyVector &operator=(const PolyVector &) = delete;
+
+    PolyVector(PolyVector &&other) noexcept
+        : buffer { std::exchange(other.buffer, nullptr) },
+          used { std::exchange(other.used, 0) },
+          capacity { std::exchange(other.capacity, 0) },
+          entries { std::move(other.entries) } {
+        other.entries.clear();
+    }
+
+    PolyVector &operator=(PolyVector &&other) noexcept {
+        if (this != &other) {
+            clear();
+            deallocate(buffer);
+            buffer = std::exchange(other.buffer, nullptr);
+            used = std::exchange(other.used, 0);
+            capacity = std::exchange(other.capacity, 0);
+            entries = std::move(other.entries);
+            other.entries.clear();
+        }
+        return *this;
+    }
+
+    ~PolyVector() {
+        clear();
+        deallocate(buffer);
+    }
+
+    /**
+     * @brief Constructs a T at the end of the sequence.
+     *
+     * @return The new object.
+     */
+    template <typename T, typename... Args>
+    T &emplace_back(Args &&...args) {
+        static_assert(std::is_base_of_v<Base, T>, "T must derive from Base");
+        static_assert(alignof(T) <= buffer_alignment,
+                      "T is over-aligned for the buffer");
+        static_assert(std::is_nothrow_move_constructible_v<T>,
+                      "T must be relocatable without throwing");
+
+        std::size_t offset = align_up(used, alignof(T));
+        if (offset + sizeof(T) > capacity)
+            grow(offset + sizeof(T));
+
+        T *object = ::new (buffer + offset) T(std::forward<Args>(args)...);
+        std::ptrdiff_t base_offset =
+            reinterpret_cast<std::byte *>(static_cast<Base *>(object)) -
+            reinterpret_cast<std::byte *>(object);
+        entries.push_back({ offset, base_offset, &relocate<T> });
+        used = offset + sizeof(T);
+
+        return *object;
+    }
+
+    /**
+     * @brief Makes room for size bytes of objects, padding included, and
+     * count entries without growing.
+     */
+    void reserve(std::size_t size, std::size_t count = 0) {
+        if (size > capacity)
+            reallocate(size);
+        entries.reserve(count);
+    }
+
+    /**
+     * @brief Destroys every object, keeping the buffer for reuse.
+     */
+    void clear() noexcept {
+        for (Base &element : *this)
+            element.~Base();
+        entries.clear();
+        used = 0;
+    }
+
+    std::size_t size() const { return entries.size(); }
+
+    bool empty() const { return entries.empty(); }
+
+    /** @brief Bytes of buffer in use, padding included. */
+    std::size_t bytes() const { return used; }
+
+    Base &operator[](std::size_t i) {
+        assert(i < entries.size());
+        return *begin_at(i);
+    }
+
+    const Base &operator[](std::size_t i) const {
+        assert(i < entries.size());
+        return *begin_at(i);
+    }
+
+    iterator begin() { return { entries.data(), buffer }; }
+    iterator end() { return { entries.data() + entries.size(), buffer }; }
+    const_iterator begin() const { return { entries.data(), buffer }; }
+    const_iterator end() const {
+        return { entries.data() + entries.size(), buffer };
+    }
+
+private:
+    static std::size_t align_up(std::size_t offset, std::size_t alignment) {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    template <typename T>
+    static void relocate(std::byte *from, std::byte *to) {
+        T *object = std::launder(reinterpret_cast<T *>(from));
+        ::new (to) T(std::move(*object));
+        object->~T();
+    }
+
+    static void deallocate(std::byte *storage) {
+        ::operator delete(storage, std::align_val_t { buffer_alignment });
+    }
+
+    iterator begin_at(std::size_t i) { return { &entries[i], buffer }; }
+    const_iterator begin_at(std::size_t i) const {
+        return { &entries[i], buffer };
+    }
+
+    void grow(std::size_t needed) {
+        std::size_t new_capacity = capacity ? capacity * 2 : 256;
+        while (new_capacity < needed)
+            new_capacity *= 2;
+        reallocate(new_capacity);
+    }
+
+    /** Moves every object to a new buffer, keeping the offsets. */
+    void reallocate(std::size_t new_capacity) {
+        auto *new_buffer = static_cast<std::byte *>(::operator new(
+            new_capacity, std::align_val_t { buffer_alignment }));
+
+        for (const Entry &entry : entries)
+            entry.relocate(buffer + entry.offset, new_buffer + entry.offset);
+
+        deallocate(buffer);
+        buffer = new_buffer;
+        capacity = new_capacity;
+    }
+
+    std::byte *buffer = nullptr;
+    std::size_t used = 0;
+    std::size_t capacity = 0;
+    std::vector<Entry> entries;
+};
+
+
+#endif
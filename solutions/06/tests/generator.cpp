@@ -0,0 +1,91 @@
+#include "../src/generator.hpp"
+
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+static int steps = 0;
+static int alive = 0;
+
+struct Guard {
+    Guard() { alive++; }
+    ~Guard() { alive--; }
+};
+
+
+static Generator<int> count_up(int n) {
+    Guard guard;
+
+    for (int i = 0; i < n; i++) {
+        steps++;
+        co_yield i;
+    }
+}
+
+static Generator<std::unique_ptr<std::string>> words() {
+    co_yield std::make_unique<std::string>("lazy");
+    co_yield std::make_unique<std::string>("words");
+}
+
+static Generator<int> failing() {
+    co_yield 1;
+    throw std::runtime_error { "broken" };
+}
+
+
+int main() {
+    // nothing runs before begin, then one step per value
+    {
+        Generator<int> numbers = count_up(5);
+        assert(steps == 0 && alive == 0);
+
+        auto it = numbers.begin();
+        assert(steps == 1 && alive == 1 && *it == 0);
+
+        ++it;
+        assert(steps == 2 && *it == 1);
+    }
+
+    // stopping early destroys the suspended frame with its locals
+    assert(alive == 0);
+
+    steps = 0;
+    std::vector<int> seen;
+    for (int i : count_up(4))
+        seen.push_back(i);
+    assert((seen == std::vector<int> { 0, 1, 2, 3 }));
+    assert(steps == 4 && alive == 0);
+
+    for (int i : count_up(0))
+        assert(false && i);
+
+    // move-only values can be moved out through the iterator
+    std::vector<std::unique_ptr<std::string>> taken;
+    for (auto &word : words())
+        taken.push_back(std::move(word));
+    assert(taken.size() == 2 && *taken[1] == "words");
+
+    // generators move, the moved-from one is empty
+    Generator<int> a = count_up(3);
+    Generator<int> b = std::move(a);
+    assert(a.begin() == a.end());
+    assert(*b.begin() == 0);
+    a = std::move(b);
+
+    // exceptions come out of the increment that resumed the coroutine
+    Generator<int> broken = failing();
+    auto it = broken.begin();
+    assert(*it == 1);
+
+    bool thrown = false;
+    try {
+        ++it;
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown && it == broken.end());
+}
@@ -0,0 +1,94 @@
+#include "../src/payload.hpp"
+#include "../src/payload_stream.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+
+static const char INPUT[] =
+    "/login alice pass123\n"
+    "\n"
+    "/join general\n"
+    "@alice @bob Hello everyone!\n"
+    "#general #random Check this out!\n"
+    "/foo bar\n"
+    "/login nobody\n"
+    "Global message to all\n"
+    "@bob\n"
+    "/logout\n";
+
+
+static std::string run(Generator<std::unique_ptr<Payload>> payloads) {
+    std::ostringstream output;
+    payload_output = &output;
+
+    process(std::move(payloads));
+
+    payload_output = &std::cout;
+    return output.str();
+}
+
+static bool is_message(const std::unique_ptr<Payload> &payload) {
+    return dynamic_cast<const Message *>(payload.get()) != nullptr;
+}
+
+
+int main() {
+    std::istringstream input { INPUT };
+
+    assert(run(parse_payloads(input)) ==
+           "Command: login\n"
+           "  Arguments: [username: alice, password: pass123]\n"
+           "Command: join\n"
+           "  Arguments: [channel: general]\n"
+           "Direct message to alice: Hello everyone!\n"
+           "Direct message to bob: Hello everyone!\n"
+           "Group message to general: Check this out!\n"
+           "Group message to random: Check this out!\n"
+           "Ignoring invalid command foo\n"
+           "Ignoring invalid command login\n"
+           "Global message: Global message to all\n"
+           "Direct message to bob: \n"
+           "Command: logout\n"
+           "  Arguments: []\n");
+
+    // stages compose, and the count covers what reached the end
+    input = std::istringstream { INPUT };
+    std::ostringstream output;
+    payload_output = &output;
+
+    assert(process(filter(parse_payloads(input), is_message)) == 6);
+    assert(output.str().find("Command") == std::string::npos);
+
+    // transform may replace payloads, here by the following command
+    input = std::istringstream { INPUT };
+    auto logouts = transform(parse_payloads(input),
+                             [](std::unique_ptr<Payload> &&) {
+                                 return std::unique_ptr<Payload> {
+                                     std::make_unique<LogoutCommand>()
+                                 };
+                             });
+    assert(process(take(std::move(logouts), 3)) == 3);
+
+    payload_output = &std::cout;
+
+    // nothing past the payloads taken is read
+    input = std::istringstream { INPUT };
+    assert(run(take(parse_payloads(input), 3)) ==
+           "Command: login\n"
+           "  Arguments: [username: alice, password: pass123]\n"
+           "Command: join\n"
+           "  Arguments: [channel: general]\n"
+           "Direct message to alice: Hello everyone!\n");
+
+    std::string next;
+    std::getline(input, next);
+    assert(next == "#general #random Check this out!");
+
+    input = std::istringstream { INPUT };
+    assert(run(take(parse_payloads(input), 0)).empty());
+    assert(input.tellg() == 0);
+}
@@ -0,0 +1,44 @@
+#include "../src/payload.hpp"
+#include "../src/payload_variant.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+
+int main() {
+    std::vector<std::unique_ptr<Payload>> objects;
+    objects.push_back(std::make_unique<LoginCommand>("alice", "pass123"));
+    objects.push_back(std::make_unique<JoinCommand>("general"));
+    objects.push_back(std::make_unique<LogoutCommand>());
+    objects.push_back(std::make_unique<DirectMessage>("hi", "bob"));
+    objects.push_back(std::make_unique<GroupMessage>("hello", "dev"));
+    objects.push_back(std::make_unique<GlobalMessage>("everyone"));
+
+    std::vector<PayloadVariant> values;
+    values.emplace_back(LoginCommand { "alice", "pass123" });
+    values.emplace_back(JoinCommand { "general" });
+    values.emplace_back(LogoutCommand {});
+    values.emplace_back(DirectMessage { "hi", "bob" });
+    values.emplace_back(GroupMessage { "hello", "dev" });
+    values.emplace_back(GlobalMessage { "everyone" });
+
+    // both representations print exactly the same
+    std::ostringstream virtual_output, variant_output;
+
+    payload_output = &virtual_output;
+    for (auto &payload : objects)
+        payload->process();
+
+    payload_output = &variant_output;
+    for (auto &payload : values)
+        process(payload);
+
+    payload_output = &std::cout;
+
+    assert(virtual_output.str() == variant_output.str());
+    assert(variant_output.str().find("Direct message to bob: hi\n") !=
+           std::string::npos);
+}
@@ -0,0 +1,128 @@
+#include "../src/payload.hpp"
+#include "../src/poly_vector.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+
+static int alive = 0;
+
+
+struct Shape {
+    virtual int value() const = 0;
+
+    virtual ~Shape() { alive--; }
+
+protected:
+    Shape() { alive++; }
+    Shape(Shape &&) noexcept { alive++; }
+};
+
+struct Small final : Shape {
+    explicit Small(char c_) : c { c_ } {}
+
+    int value() const override { return c; }
+
+    char c;
+};
+
+struct Wide final : Shape {
+    explicit Wide(long double x_) : x { x_ } {}
+
+    int value() const override { return (int)x; }
+
+    long double x;
+};
+
+struct Owning final : Shape {
+    explicit Owning(std::string s_) : s { std::move(s_) } {}
+
+    int value() const override { return (int)s.size(); }
+
+    std::string s;
+};
+
+
+static void test_growth_and_alignment() {
+    PolyVector<Shape> shapes;
+    assert(shapes.empty());
+
+    // mixed sizes and alignments, enough to grow the buffer many times
+    for (int i = 0; i < 3000; i++) {
+        switch (i % 3) {
+        case 0: shapes.emplace_back<Small>((char)(i % 100)); break;
+        case 1: shapes.emplace_back<Wide>(i); break;
+        default: shapes.emplace_back<Owning>(std::string(i % 40, 'x'));
+        }
+    }
+    assert(shapes.size() == 3000);
+    assert(alive == 3000);
+
+    int i = 0;
+    for (const Shape &shape : shapes) {
+        auto address = reinterpret_cast<std::uintptr_t>(&shape);
+        switch (i % 3) {
+        case 0:
+            assert(shape.value() == i % 100);
+            assert(address % alignof(Small) == 0);
+            break;
+        case 1:
+            assert(shape.value() == i);
+            assert(address % alignof(Wide) == 0);
+            break;
+        default:
+            assert(shape.value() == i % 40);
+            assert(address % alignof(Owning) == 0);
+        }
+        i++;
+    }
+    assert(i == 3000);
+    assert(shapes[1].value() == 1);
+
+    // objects follow one another in the buffer
+    assert(&shapes[1] > &shapes[0] && &shapes[2] > &shapes[1]);
+
+    PolyVector<Shape> moved = std::move(shapes);
+    assert(shapes.empty() && moved.size() == 3000);
+    assert(alive == 3000);
+
+    moved.clear();
+    assert(moved.empty() && moved.bytes() == 0);
+    assert(alive == 0);
+
+    moved.emplace_back<Small>('a');
+    assert(alive == 1);
+}
+
+static void test_payloads() {
+    std::ostringstream output;
+    payload_output = &output;
+
+    PolyVector<Payload> payloads;
+    payloads.reserve(1024, 3);
+    payloads.emplace_back<LoginCommand>("alice", "pass123");
+    payloads.emplace_back<GroupMessage>("hello", "dev");
+    payloads.emplace_back<LogoutCommand>();
+    for (Payload &payload : payloads)
+        payload.process();
+
+    payload_output = &std::cout;
+
+    assert(output.str() ==
+           "Command: login\n"
+           "  Arguments: [username: alice, password: pass123]\n"
+           "Group message to dev: hello\n"
+           "Command: logout\n"
+           "  Arguments: []\n");
+}
+
+
+int main() {
+    test_growth_and_alignment();
+    assert(alive == 0);
+
+    test_payloads();
+}